@@ -7,6 +7,7 @@
 #include <mutex>
 #include <unordered_set>
 #include "PlotJuggler/plotdata.h"
+#include "PlotJuggler/spsc_queue.h"
 
 /**
  * @brief The DataStreamer base class to create your own plugin.
@@ -15,6 +16,11 @@
  * dataMap(), which share its elements with the main application, is protected by the mutex()
  *
  * This includes in particular the periodic updates.
+ *
+ * As an alternative, numeric samples can be sent with pushBatch(), that does not block
+ * while the application consumes the data: register each series once with
+ * registerNumericSeries() and push from a single thread batches of samples
+ * that refer to the returned handles.
  */
 class DataStreamer: public QObject{
 
@@ -56,6 +62,33 @@ public:
         return _data_map;
     }
 
+    // Index into the table of registerNumericSeries(). These handles are NOT the ones
+    // of PlotDataMapRef::numericHandle(), that must never be passed to pushBatch().
+    typedef size_t SeriesHandle;
+
+    struct Sample
+    {
+        SeriesHandle series;
+        double time;
+        double value;
+    };
+
+    typedef std::vector<Sample> SampleBatch;
+
+    /// Return the handle of a numeric series, to be used in pushBatch().
+    /// Takes the mutex(), therefore it should be called once per series and not per sample.
+    SeriesHandle registerNumericSeries(const std::string& name);
+
+    /// Must be always called by the same thread. The samples are never lost: it is lock-free
+    /// as long as the application consumes the queue, otherwise (for instance, while
+    /// streaming is paused) it takes the mutex() and moves the samples into dataMap().
+    /// The batch is left empty.
+    void pushBatch(SampleBatch& batch);
+
+    /// Move the samples pushed with pushBatch() into dataMap().
+    /// Called by the application, that must hold the mutex().
+    void consumeQueuedBatches();
+
 signals:
 
     void clearBuffers();
@@ -67,10 +100,75 @@ signals:
 protected:
     QMenu* _menu;
 private:
+    void appendBatch(const SampleBatch& batch, std::vector<PlotData*>& series);
+
     std::mutex _mutex;
     PlotDataMapRef _data_map;
+    std::unordered_map<std::string, SeriesHandle> _series_handles;
+    std::vector<std::string> _series_names;
+    SPSCQueue<SampleBatch> _batch_queue;
 };
 
+inline DataStreamer::SeriesHandle DataStreamer::registerNumericSeries(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+    auto it = _series_handles.find( name );
+    if( it != _series_handles.end() )
+    {
+        return it->second;
+    }
+    _data_map.addNumeric( name );
+    const SeriesHandle handle = _series_names.size();
+    _series_names.push_back( name );
+    _series_handles.insert( {name, handle} );
+    return handle;
+}
+
+inline void DataStreamer::pushBatch(SampleBatch& batch)
+{
+    if( _batch_queue.push( batch ) )
+    {
+        return;
+    }
+    // the application is not consuming the queue: append to dataMap(), after
+    // the batches already queued, so that they are shown when it resumes.
+    std::lock_guard<std::mutex> lock( _mutex );
+    consumeQueuedBatches();
+    std::vector<PlotData*> series( _series_names.size(), nullptr );
+    appendBatch( batch, series );
+    batch.clear();
+}
+
+inline void DataStreamer::consumeQueuedBatches()
+{
+    if( _batch_queue.empty() )
+    {
+        return;
+    }
+    // series are resolved by name once per call, because the plugin
+    // is allowed to remove elements from dataMap() at any time.
+    std::vector<PlotData*> series( _series_names.size(), nullptr );
+
+    SampleBatch batch;
+    while( _batch_queue.pop( batch ) )
+    {
+        appendBatch( batch, series );
+    }
+}
+
+inline void DataStreamer::appendBatch(const SampleBatch& batch, std::vector<PlotData*>& series)
+{
+    for(const Sample& sample: batch)
+    {
+        PlotData*& plot = series[ sample.series ];
+        if( !plot )
+        {
+            plot = &( _data_map.addNumeric( _series_names[ sample.series ] )->second );
+        }
+        plot->pushBack( PlotData::Point( sample.time, sample.value ) );
+    }
+}
+
 QT_BEGIN_NAMESPACE
 
 #define DataStream_iid "com.icarustechnology.PlotJuggler.DataStreamer"
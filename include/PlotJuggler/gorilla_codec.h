@@ -0,0 +1,267 @@
+#ifndef PJ_GORILLA_CODEC_H
+#define PJ_GORILLA_CODEC_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+/**
+ * Lossless compression of columns of doubles, as described in the paper
+ * "Gorilla: A Fast, Scalable, In-Memory Time Series Database" (Facebook, 2015).
+ *
+ * - Timestamps are encoded as delta-of-delta of their bit pattern: when the period is
+ *   (almost) constant, most samples take between 1 and 10 bits.
+ * - Values are XORed with the previous one and only the meaningful bits are stored.
+ */
+namespace GorillaCodec
+{
+
+class BitWriter
+{
+public:
+  explicit BitWriter(std::vector<uint8_t>& out): _out(out), _buffer(0), _bits(0) {}
+
+  // write the "count" least significant bits of value, count <= 64
+  void write(uint64_t value, int count)
+  {
+    while( count > 0 )
+    {
+      const int chunk = (count > 32) ? 32 : count;
+      count -= chunk;
+      const uint64_t bits = (value >> count) & ((uint64_t(1) << chunk) - 1);
+      _buffer = (_buffer << chunk) | bits;
+      _bits += chunk;
+      while( _bits >= 8 )
+      {
+        _bits -= 8;
+        _out.push_back( uint8_t(_buffer >> _bits) );
+      }
+    }
+  }
+
+  void flush()
+  {
+    if( _bits > 0 )
+    {
+      _out.push_back( uint8_t(_buffer << (8 - _bits)) );
+      _bits = 0;
+    }
+  }
+
+private:
+  std::vector<uint8_t>& _out;
+  uint64_t _buffer;
+  int _bits;
+};
+
+class BitReader
+{
+public:
+  explicit BitReader(const std::vector<uint8_t>& in): _in(in), _pos(0), _buffer(0), _bits(0) {}
+
+  uint64_t read(int count)
+  {
+    uint64_t value = 0;
+    while( count > 0 )
+    {
+      if( _bits == 0 )
+      {
+        _buffer = (_pos < _in.size()) ? _in[_pos] : 0;
+        _pos++;
+        _bits = 8;
+      }
+      const int chunk = (count < _bits) ? count : _bits;
+      _bits -= chunk;
+      count -= chunk;
+      value = (value << chunk) | ((_buffer >> _bits) & ((1u << chunk) - 1));
+    }
+    return value;
+  }
+
+private:
+  const std::vector<uint8_t>& _in;
+  size_t _pos;
+  uint32_t _buffer;
+  int _bits;
+};
+
+inline uint64_t toBits(double value)
+{
+  uint64_t bits;
+  std::memcpy( &bits, &value, sizeof(bits) );
+  return bits;
+}
+
+inline double fromBits(uint64_t bits)
+{
+  double value;
+  std::memcpy( &value, &bits, sizeof(value) );
+  return value;
+}
+
+inline int leadingZeros(uint64_t v)
+{
+  int n = 0;
+  for(uint64_t mask = uint64_t(1) << 63; mask && !(v & mask); mask >>= 1) n++;
+  return n;
+}
+
+inline int trailingZeros(uint64_t v)
+{
+  int n = 0;
+  for(; n < 64 && !(v & 1); v >>= 1) n++;
+  return n;
+}
+
+inline void encodeTimes(const double* times, size_t count, std::vector<uint8_t>& out)
+{
+  BitWriter writer(out);
+  uint64_t prev = 0;
+  uint64_t prev_delta = 0;
+  for(size_t i=0; i < count; i++)
+  {
+    const uint64_t bits = toBits(times[i]);
+    if( i < 2 )
+    {
+      writer.write( bits, 64 );
+    }
+    else{
+      // zig-zag encoding of the (wrapping) delta of delta
+      const int64_t dod = int64_t( (bits - prev) - prev_delta );
+      const uint64_t zz = (uint64_t(dod) << 1) ^ uint64_t(dod >> 63);
+      if( zz == 0 ) {
+        writer.write( 0, 1 );
+      }
+      else if( zz < (1 << 7) ) {
+        writer.write( 0x2, 2 );
+        writer.write( zz, 7 );
+      }
+      else if( zz < (1 << 12) ) {
+        writer.write( 0x6, 3 );
+        writer.write( zz, 12 );
+      }
+      else if( zz < (1 << 20) ) {
+        writer.write( 0xE, 4 );
+        writer.write( zz, 20 );
+      }
+      else{
+        writer.write( 0xF, 4 );
+        writer.write( zz, 64 );
+      }
+    }
+    if( i > 0 ) {
+      prev_delta = bits - prev;
+    }
+    prev = bits;
+  }
+  writer.flush();
+}
+
+inline void decodeTimes(const std::vector<uint8_t>& in, size_t count, double* times)
+{
+  BitReader reader(in);
+  uint64_t prev = 0;
+  uint64_t prev_delta = 0;
+  for(size_t i=0; i < count; i++)
+  {
+    uint64_t bits;
+    if( i < 2 )
+    {
+      bits = reader.read(64);
+    }
+    else{
+      int length = 64;
+      if( reader.read(1) == 0 )      { length = 0; }
+      else if( reader.read(1) == 0 ) { length = 7; }
+      else if( reader.read(1) == 0 ) { length = 12; }
+      else if( reader.read(1) == 0 ) { length = 20; }
+
+      const uint64_t zz = (length > 0) ? reader.read(length) : 0;
+      const uint64_t dod = (zz >> 1) ^ (~(zz & 1) + 1);
+      bits = prev + prev_delta + dod;
+    }
+    if( i > 0 ) {
+      prev_delta = bits - prev;
+    }
+    prev = bits;
+    times[i] = fromBits(bits);
+  }
+}
+
+inline void encodeValues(const double* values, size_t count, std::vector<uint8_t>& out)
+{
+  BitWriter writer(out);
+  uint64_t prev = 0;
+  int prev_leading = -1;
+  int prev_trailing = 0;
+  for(size_t i=0; i < count; i++)
+  {
+    const uint64_t bits = toBits(values[i]);
+    if( i == 0 )
+    {
+      writer.write( bits, 64 );
+    }
+    else{
+      const uint64_t xored = bits ^ prev;
+      if( xored == 0 )
+      {
+        writer.write( 0, 1 );
+      }
+      else{
+        const int leading  = leadingZeros(xored);
+        const int trailing = trailingZeros(xored);
+        if( prev_leading >= 0 && leading >= prev_leading && trailing >= prev_trailing )
+        {
+          // the meaningful bits fit in the previous window
+          writer.write( 0x2, 2 );
+          writer.write( xored >> prev_trailing, 64 - prev_leading - prev_trailing );
+        }
+        else{
+          const int meaningful = 64 - leading - trailing;
+          writer.write( 0x3, 2 );
+          writer.write( uint64_t(leading), 6 );
+          writer.write( uint64_t(meaningful - 1), 6 );
+          writer.write( xored >> trailing, meaningful );
+          prev_leading = leading;
+          prev_trailing = trailing;
+        }
+      }
+    }
+    prev = bits;
+  }
+  writer.flush();
+}
+
+inline void decodeValues(const std::vector<uint8_t>& in, size_t count, double* values)
+{
+  BitReader reader(in);
+  uint64_t prev = 0;
+  int prev_leading = 0;
+  int prev_trailing = 0;
+  for(size_t i=0; i < count; i++)
+  {
+    uint64_t bits = prev;
+    if( i == 0 )
+    {
+      bits = reader.read(64);
+    }
+    else if( reader.read(1) == 1 )
+    {
+      if( reader.read(1) == 1 )
+      {
+        prev_leading = int( reader.read(6) );
+        const int meaningful = int( reader.read(6) ) + 1;
+        prev_trailing = 64 - prev_leading - meaningful;
+      }
+      const int meaningful = 64 - prev_leading - prev_trailing;
+      bits = prev ^ ( reader.read(meaningful) << prev_trailing );
+    }
+    prev = bits;
+    values[i] = fromBits(bits);
+  }
+}
+
+} // end namespace
+
+#endif // PJ_GORILLA_CODEC_H
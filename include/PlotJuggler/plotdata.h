@@ -7,8 +7,13 @@
 #include <map>
 #include <mutex>
 #include <deque>
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <atomic>
 #include "PlotJuggler/optional.hpp"
 #include "PlotJuggler/any.hpp"
+#include "PlotJuggler/gorilla_codec.h"
 #include <QDebug>
 #include <QColor>
 #include <type_traits>
@@ -21,6 +26,282 @@ inline double Abs(double val)
     return val < 0 ? -val : val;
 }
 
+/**
+ * @brief Hierarchy of min/max summaries over contiguous blocks of samples.
+ *
+ * Level L stores the range of the blocks of BRANCHING^(L+1) samples.
+ * Samples are identified by an absolute position that keeps increasing
+ * when older samples are evicted. This allows to compute the range of any
+ * interval of samples in O(log N).
+ */
+template <typename Value> class MinMaxPyramid
+{
+public:
+
+  enum{
+    BRANCHING_BITS = 5,
+    BRANCHING = 1 << BRANCHING_BITS,
+    BRANCHING_MASK = BRANCHING - 1
+  };
+
+  struct Range{
+    Value min;
+    Value max;
+  };
+
+  void clear()
+  {
+    for(auto& level: _levels) {
+      level.blocks.clear(); // keep the levels, to avoid allocations when streaming
+    }
+  }
+
+  // positions must be consecutive
+  void push(size_t pos, Value y);
+
+  // drop the blocks that contain only positions older than first_pos
+  void evictBefore(size_t first_pos);
+
+  // range of the positions [first_pos, last_pos). Get_sample(pos) returns the value of a single sample
+  template <typename GetSample>
+  Range range(size_t first_pos, size_t last_pos, const GetSample& get_sample) const;
+
+private:
+
+  struct Level{
+    std::deque<Range> blocks;
+    size_t first_block;
+    const Range& block(size_t index) const { return blocks[index - first_block]; }
+  };
+
+  static void extend(Range& range, const Value& y)
+  {
+    if( y < range.min ) range.min = y;
+    if( y > range.max ) range.max = y;
+  }
+
+  std::vector<Level> _levels;
+};
+
+template <typename Value>
+inline void MinMaxPyramid<Value>::push(size_t pos, Value y)
+{
+  if( _levels.empty() )
+  {
+    _levels.push_back( { std::deque<Range>(), pos >> BRANCHING_BITS } );
+  }
+
+  for(size_t L=0; L < _levels.size(); L++)
+  {
+    Level& level = _levels[L];
+    const size_t block = pos >> ( (L+1)*BRANCHING_BITS );
+    if( level.blocks.empty() || block >= level.first_block + level.blocks.size() )
+    {
+      if( level.blocks.empty() ) {
+        level.first_block = block;
+      }
+      level.blocks.push_back( {y,y} );
+    }
+    else{
+      Range& range = level.blocks.back();
+      if( !(y < range.min) && !(y > range.max) )
+      {
+        break; // the upper levels already include y
+      }
+      extend( range, y );
+    }
+  }
+
+  // add a level on top, when needed
+  while( _levels.back().blocks.size() > 1 )
+  {
+    const Level& top = _levels.back();
+    Level parent;
+    parent.first_block = top.first_block >> BRANCHING_BITS;
+    for(size_t i=0; i < top.blocks.size(); i++)
+    {
+      const Range& child = top.blocks[i];
+      const size_t block = (top.first_block + i) >> BRANCHING_BITS;
+      if( parent.blocks.empty() || block >= parent.first_block + parent.blocks.size() )
+      {
+        parent.blocks.push_back( child );
+      }
+      else{
+        extend( parent.blocks.back(), child.min );
+        extend( parent.blocks.back(), child.max );
+      }
+    }
+    _levels.push_back( std::move(parent) );
+  }
+}
+
+template <typename Value>
+inline void MinMaxPyramid<Value>::evictBefore(size_t first_pos)
+{
+  for(size_t L=0; L < _levels.size(); L++)
+  {
+    Level& level = _levels[L];
+    const size_t first_block = first_pos >> ( (L+1)*BRANCHING_BITS );
+    while( !level.blocks.empty() && level.first_block < first_block )
+    {
+      level.blocks.pop_front();
+      level.first_block++;
+    }
+  }
+}
+
+template <typename Value> template <typename GetSample>
+inline typename MinMaxPyramid<Value>::Range
+MinMaxPyramid<Value>::range(size_t first_pos, size_t last_pos, const GetSample& get_sample) const
+{
+  Range out = { std::numeric_limits<Value>::max(), std::numeric_limits<Value>::lowest() };
+
+  // single samples at the borders of the interval, until it is aligned with the blocks
+  size_t lo = first_pos;
+  size_t hi = last_pos;
+  while( lo < hi && (lo & BRANCHING_MASK) ) { extend( out, get_sample(lo++) ); }
+  while( lo < hi && (hi & BRANCHING_MASK) ) { extend( out, get_sample(--hi) ); }
+  lo >>= BRANCHING_BITS;
+  hi >>= BRANCHING_BITS;
+
+  // then climb the pyramid. [lo,hi) are the blocks of level L entirely inside the interval
+  for(size_t L=0; L < _levels.size() && lo < hi; L++)
+  {
+    const Level& level = _levels[L];
+    if( L+1 == _levels.size() )
+    {
+      while( lo < hi ) {
+        const Range& r = level.block(lo++);
+        extend( out, r.min );
+        extend( out, r.max );
+      }
+      break;
+    }
+    while( lo < hi && (lo & BRANCHING_MASK) ) {
+      const Range& r = level.block(lo++);
+      extend( out, r.min );
+      extend( out, r.max );
+    }
+    while( lo < hi && (hi & BRANCHING_MASK) ) {
+      const Range& r = level.block(--hi);
+      extend( out, r.min );
+      extend( out, r.max );
+    }
+    lo >>= BRANCHING_BITS;
+    hi >>= BRANCHING_BITS;
+  }
+  return out;
+}
+
+//-----------------------------------
+
+/**
+ * @brief Minimum and maximum of a sliding window of samples, using two monotonic deques.
+ *
+ * Samples are pushed at the back and evicted from the front, both in O(1) amortized,
+ * and the range of the whole window is available in O(1).
+ */
+template <typename Value> class SlidingMinMax
+{
+public:
+
+  void clear()
+  {
+    _min.clear();
+    _max.clear();
+  }
+
+  bool empty() const { return _min.empty(); }
+
+  // unlike std::swap, that moves through a temporary, it never allocates
+  void swap(SlidingMinMax& other)
+  {
+    _min.swap( other._min );
+    _max.swap( other._max );
+  }
+
+  // positions must be increasing
+  void push(size_t pos, const Value& y)
+  {
+    while( !_min.empty() && !(_min.back().value < y) ) _min.pop_back();
+    while( !_max.empty() && !(_max.back().value > y) ) _max.pop_back();
+    _min.push_back( {pos, y} );
+    _max.push_back( {pos, y} );
+  }
+
+  // forget the positions older than first_pos
+  void evictBefore(size_t first_pos)
+  {
+    while( !_min.empty() && _min.front().pos < first_pos ) _min.pop_front();
+    while( !_max.empty() && _max.front().pos < first_pos ) _max.pop_front();
+  }
+
+  const Value& min() const { return _min.front().value; }
+
+  const Value& max() const { return _max.front().value; }
+
+private:
+  struct Entry{
+    size_t pos;
+    Value value;
+  };
+  std::deque<Entry> _min; // increasing values
+  std::deque<Entry> _max; // decreasing values
+};
+
+/**
+ * @brief Mean and variance of a sequence of values, updated in O(1) with the
+ * Welford algorithm. Values can also be removed, in the same order they were added,
+ * to follow a sliding window.
+ */
+class RunningStatistics
+{
+public:
+  RunningStatistics(): _count(0), _mean(0), _m2(0) {}
+
+  void clear()
+  {
+    _count = 0;
+    _mean = 0;
+    _m2 = 0;
+  }
+
+  void add(double value)
+  {
+    _count++;
+    const double delta = value - _mean;
+    _mean += delta / double(_count);
+    _m2 += delta * (value - _mean);
+  }
+
+  void remove(double value)
+  {
+    if( _count <= 1 )
+    {
+      clear();
+      return;
+    }
+    _count--;
+    const double delta = value - _mean;
+    _mean -= delta / double(_count);
+    _m2 = std::max( 0.0, _m2 - delta * (value - _mean) );
+  }
+
+  size_t count() const { return _count; }
+
+  double mean() const { return _mean; }
+
+  // population variance
+  double variance() const { return _count > 0 ? _m2 / double(_count) : 0.0; }
+
+private:
+  size_t _count;
+  double _mean;
+  double _m2;
+};
+
+//-----------------------------------
+
 template <typename Time, typename Value> class PlotDataGeneric
 {
 public:
@@ -38,6 +319,15 @@ public:
   typedef nonstd::optional<RangeTime>  RangeTimeOpt;
   typedef nonstd::optional<RangeValue> RangeValueOpt;
 
+  struct Statistics{
+    size_t count;
+    Value min;
+    Value max;
+    double mean;
+    double variance;
+    double stddev() const { return std::sqrt(variance); }
+  };
+
   class Point{
   public:
     Time x;
@@ -47,18 +337,174 @@ public:
     Point() = default;   
   };
 
+  // Samples are stored column-wise, therefore there is no Point object
+  // to refer to. These proxies reference directly the time and value columns.
+  // The time is a copy, because it might be computed (see Chunk).
+  class ConstPointRef{
+  public:
+    const Time x;
+    const Value& y;
+    ConstPointRef( const Time& _x, const Value& _y):
+        x(_x), y(_y) {}
+    operator Point() const { return Point(x,y); }
+  };
+
+  class PointRef{
+  public:
+    Time& x;
+    Value& y;
+    PointRef( Time& _x, Value& _y):
+        x(_x), y(_y) {}
+    PointRef& operator = (const Point& p) { x = p.x; y = p.y; return *this; }
+    operator Point() const { return Point(x,y); }
+    operator ConstPointRef() const { return ConstPointRef(x,y); }
+  };
+
   enum{
     MAX_CAPACITY = 1024*1024,
-    ASYNC_BUFFER_CAPACITY = 1024
+    ASYNC_BUFFER_CAPACITY = 1024,
+    CHUNK_BITS = 10,
+    CHUNK_SIZE = 1 << CHUNK_BITS,
+    CHUNK_MASK = CHUNK_SIZE - 1
   };
 
   typedef Time    TimeType;
 
   typedef Value   ValueType;
 
-  typedef typename std::deque<Point>::iterator Iterator;
+  // Fixed size block of samples. Time and value columns are contiguous.
+  // All the chunks are full, but the last one.
+  // The time column can be shared with other series (see shareTimeColumnWith)
+  // and it is copied before being modified.
+  // A full chunk can be compressed (see compress): the compressed columns are
+  // stored in packed_x / packed_y and x / y are released.
+  // When the timestamps of a full chunk are periodic, x is released too and
+  // they are computed as t0 + index * dt (see makeImplicit).
+  struct Chunk{
+    Chunk(): x( std::make_shared<std::vector<Time>>() ), packed(false), implicit_x(false) {}
+    std::shared_ptr<std::vector<Time>> x;
+    std::vector<Value> y;
+
+    std::vector<uint8_t> packed_x;
+    std::vector<uint8_t> packed_y;
+    Time back_x; // last timestamp, valid when x is compressed
+    bool packed;
+
+    Time t0;
+    Time dt;
+    bool implicit_x;
+
+    size_t count() const { return packed ? size_t(CHUNK_SIZE) : y.size(); }
+
+    Time time(size_t index) const { return implicit_x ? t0 + Time(index) * dt : (*x)[index]; }
+
+    Time back() const
+    {
+      if( !packed_x.empty() ) return back_x;
+      return implicit_x ? time(CHUNK_SIZE-1) : x->back();
+    }
+
+    std::vector<Time>& writableX()
+    {
+      if( implicit_x )
+      {
+        x = std::make_shared<std::vector<Time>>( CHUNK_SIZE );
+        for(size_t i=0; i < CHUNK_SIZE; i++)
+        {
+          (*x)[i] = time(i);
+        }
+        implicit_x = false;
+      }
+      else if( x.use_count() > 1 )
+      {
+        auto copy = std::make_shared<std::vector<Time>>();
+        copy->reserve( x->capacity() );
+        copy->assign( x->begin(), x->end() );
+        x = std::move(copy);
+      }
+      return *x;
+    }
+  };
+
+  template <typename DataPtr, typename Reference>
+  class IteratorBase
+  {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef Point          value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef void           pointer;
+    typedef Reference      reference;
+
+    IteratorBase(): _data(nullptr), _index(0) {}
+    IteratorBase(DataPtr data, size_t index): _data(data), _index(index) {}
+
+    Reference operator*() const { return _data->at(_index); }
+    Reference operator[](difference_type n) const { return _data->at(_index + n); }
+
+    IteratorBase& operator++() { ++_index; return *this; }
+    IteratorBase& operator--() { --_index; return *this; }
+    IteratorBase operator++(int) { IteratorBase tmp(*this); ++_index; return tmp; }
+    IteratorBase operator--(int) { IteratorBase tmp(*this); --_index; return tmp; }
+    IteratorBase& operator+=(difference_type n) { _index += n; return *this; }
+    IteratorBase& operator-=(difference_type n) { _index -= n; return *this; }
+    IteratorBase operator+(difference_type n) const { return IteratorBase(_data, _index + n); }
+    IteratorBase operator-(difference_type n) const { return IteratorBase(_data, _index - n); }
+    difference_type operator-(const IteratorBase& other) const
+    {
+      return difference_type(_index) - difference_type(other._index);
+    }
+
+    bool operator==(const IteratorBase& other) const { return _index == other._index; }
+    bool operator!=(const IteratorBase& other) const { return _index != other._index; }
+    bool operator<(const IteratorBase& other)  const { return _index <  other._index; }
+    bool operator>(const IteratorBase& other)  const { return _index >  other._index; }
+    bool operator<=(const IteratorBase& other) const { return _index <= other._index; }
+    bool operator>=(const IteratorBase& other) const { return _index >= other._index; }
+
+  private:
+    DataPtr _data;
+    size_t _index;
+  };
+
+  typedef IteratorBase<PlotDataGeneric*, PointRef> Iterator;
+
+  typedef IteratorBase<const PlotDataGeneric*, ConstPointRef> ConstIterator;
+
+  // Remembers the position of the last lookup. When consecutive lookups are close
+  // to each other (for instance monotone sequences), they cost O(1) amortized instead
+  // of O(log N). It never becomes invalid: at worst it is a bad starting point.
+  class Cursor{
+  public:
+    Cursor(): _index(0) {}
+  private:
+    friend class PlotDataGeneric;
+    size_t _index;
+  };
 
-  typedef typename std::deque<Point>::const_iterator ConstIterator;
+  // Consecutive samples stored in the same chunk, see spans().
+  // Values are contiguous in memory; timestamps too, unless they are periodic
+  // and computed on the fly (times() returns nullptr in that case).
+  // A Span is invalidated by any modification of the series.
+  class Span{
+  public:
+    size_t size() const { return _count; }
+    // index in the series of the first sample of the span
+    size_t firstIndex() const { return _first_index; }
+    Time time(size_t i) const { return _x ? _x[i] : _t0 + Time(_offset + i) * _dt; }
+    const Value& value(size_t i) const { return _y[i]; }
+    const Time* times() const { return _x; }
+    const Value* values() const { return _y; }
+  private:
+    friend class PlotDataGeneric;
+    const Time* _x;
+    const Value* _y;
+    Time _t0;
+    Time _dt;
+    size_t _offset;
+    size_t _count;
+    size_t _first_index;
+  };
 
   PlotDataGeneric(const std::string& name);
 
@@ -66,7 +512,25 @@ public:
 
   void swapData( PlotDataGeneric<Time,Value>& other)
   {
-      std::swap(_points, other._points);
+      std::swap(_chunks, other._chunks);
+      std::swap(_front, other._front);
+      std::swap(_size, other._size);
+      std::swap(_evicted_count, other._evicted_count);
+      std::swap(_minmax_index, other._minmax_index);
+      std::swap(_minmax_end, other._minmax_end);
+      std::swap(_minmax_dirty, other._minmax_dirty);
+      _window_minmax.swap( other._window_minmax );
+      std::swap(_window_minmax_end, other._window_minmax_end);
+      std::swap(_stats, other._stats);
+      std::swap(_stats_end, other._stats_end);
+      std::swap(_stats_evicted, other._stats_evicted);
+      std::swap(_stats_dirty, other._stats_dirty);
+      const int search_score = _search_score.load( std::memory_order_relaxed );
+      _search_score.store( other._search_score.load( std::memory_order_relaxed ),
+                           std::memory_order_relaxed );
+      other._search_score.store( search_score, std::memory_order_relaxed );
+      _generation = nextGeneration();
+      other._generation = nextGeneration();
   }
 
   PlotDataGeneric& operator = (const PlotDataGeneric<Time,Value>& other) = delete;
@@ -79,20 +543,89 @@ public:
 
   int getIndexFromX(Time x) const;
 
+  // index of the first element with time greater or equal than x (size() if none).
+  // Uses interpolation search when the samples are (almost) evenly spaced in time,
+  // binary search otherwise.
+  size_t lowerBound(Time x) const;
+
   nonstd::optional<Value> getYfromX(Time x ) const;
 
-  const Point &at(size_t index) const;
+  // same as above, starting the search from the cursor (galloping search)
+  size_t lowerBound(Time x, Cursor& cursor) const;
+
+  int getIndexFromX(Time x, Cursor& cursor) const;
+
+  nonstd::optional<Value> getYfromX(Time x, Cursor& cursor) const;
+
+  // index of the first element with time strictly greater than x (size() if none)
+  size_t upperBound(Time x) const;
+
+  // Samples with index in [first_index, last_index), one Span per chunk
+  std::vector<Span> spans(size_t first_index, size_t last_index) const;
+
+  // Samples with t_min <= time <= t_max, one Span per chunk
+  std::vector<Span> spansInRange(Time t_min, Time t_max) const;
 
-  Point &at(size_t index);
+  ConstPointRef at(size_t index) const;
 
-  const Point& operator[](size_t index) const { return at(index); }
+  PointRef at(size_t index);
 
-  Point& operator[](size_t index) { return at(index); }
+  ConstPointRef operator[](size_t index) const { return at(index); }
+
+  PointRef operator[](size_t index) { return at(index); }
+
+  Time timeAt(size_t index) const;
+
+  const Value& valueAt(size_t index) const;
+
+  // Range of the values in [first_index, last_index). O(log N), numeric values only
+  RangeValueOpt rangeY(size_t first_index, size_t last_index) const;
+
+  // Count, range, mean and variance of all the values. Numeric values only.
+  // It is updated incrementally: O(1) amortized for each sample added or evicted.
+  Statistics statistics() const;
 
   void clear();
 
   void pushBack(Point p);
 
+  // Append many samples at once. Invalid values are skipped and the time window
+  // is applied only once, at the end.
+  void pushBackBatch(const Time* times, const Value* values, size_t count);
+
+  // Move all the samples of other at the end of this series, leaving other empty.
+  // Entire chunks are moved instead of copied when possible; if other is time windowed,
+  // it receives as many spare chunks in exchange, to avoid a new allocation later.
+  void appendFrom(PlotDataGeneric& other);
+
+  // Move the spare chunks of other to this series, that will reuse them
+  // instead of allocating new ones.
+  void takeSpareChunks(PlotDataGeneric& other);
+
+  // Preallocate the memory needed to store a total of "capacity" samples
+  void reserve(size_t capacity);
+
+  // If "reference" has exactly the same timestamps, use its time column instead of
+  // a copy. Otherwise return false and leave this series unchanged. O(N)
+  template <typename OtherValue>
+  bool shareTimeColumnWith(const PlotDataGeneric<Time, OtherValue>& reference);
+
+  // True if the two series have the same time column, in O(N / CHUNK_SIZE)
+  template <typename OtherValue>
+  bool isTimeColumnSharedWith(const PlotDataGeneric<Time, OtherValue>& other) const;
+
+  // Compress all the chunks but the last one, to save memory when the series is not used.
+  // A compressed chunk is decompressed transparently when one of its samples is accessed.
+  // Only series of doubles are compressed. Return the number of bytes saved by this call.
+  size_t compress();
+
+  // Memory currently saved by compression, in bytes
+  size_t compressionSavings() const;
+
+  // Decompress all the chunks. Until the next call to compress(), the const methods
+  // don't modify the series and can be safely called by multiple threads at once.
+  void decompress();
+
   QColor getColorHint() const;
 
   void setColorHint(QColor color);
@@ -101,30 +634,134 @@ public:
 
   Time maximumRangeX() const { return _max_range_X; }
 
-  const Point& front() const { return _points.front(); }
+  // Number of samples evicted from the front since the last clear()
+  size_t evictedCount() const { return _evicted_count; }
+
+  // Changes every time the samples are modified in a way other than appending them
+  // at the back or evicting them from the front. Unique across all the series.
+  // Caches built incrementally on top of a series must be rebuilt when it changes.
+  size_t generation() const { return _generation; }
+
+  ConstPointRef front() const { return at(0); }
 
-  const Point& back() const { return _points.back(); }
+  ConstPointRef back() const { return at(_size-1); }
 
-  ConstIterator begin() const { return _points.begin(); }
+  ConstIterator begin() const { return ConstIterator(this, 0); }
 
-  ConstIterator end() const { return _points.end(); }
+  ConstIterator end() const { return ConstIterator(this, _size); }
 
-  Iterator begin() { return _points.begin(); }
+  Iterator begin() { return Iterator(this, 0); }
 
-  Iterator end() { return _points.end(); }
+  Iterator end() { return Iterator(this, _size); }
 
-  void resize(size_t new_size) { _points.resize(new_size); }
+  void resize(size_t new_size);
 
-  void popFront() { _points.pop_front(); }
+  void popFront();
+
+  void popFront(size_t count);
 
 protected:
 
   std::string _name;
-  std::deque<Point> _points;
   QColor _color_hint;
 
 private:
+
+  template <typename T, typename V> friend class PlotDataGeneric;
+
+  static bool isValidValue(const Value&) { return true; }
+
+  // remove the first "count" samples from the running statistics, before they are evicted
+  void evictFromStatistics(size_t) {}
+
+  // index of the sample closest to x, given its lower bound
+  int nearestIndex(Time x, size_t lower) const;
+
+  // lower bound of x, searching around "start" with steps of increasing size.
+  // "probes" is incremented by the number of samples that were compared with x.
+  size_t gallopingSearch(Time x, size_t start, size_t& probes) const;
+
+  // lower bound of x, estimating its position with a linear interpolation of the timestamps
+  size_t interpolationSearch(Time x, size_t& probes) const;
+
+  // lower bound of x, using a binary search over chunks first and samples later
+  size_t binarySearch(Time x) const;
+
+  // last chunk, with space for at least one more sample
+  Chunk& writableChunk();
+
+  // decompress the chunk if needed. It is logically const, the samples don't change.
+  const Chunk& unpackedChunk(size_t chunk_index) const;
+
+  Chunk& unpackedChunk(size_t chunk_index);
+
+  static void unpackChunk(Chunk&) {}
+
+  // release the time column of a full chunk, if its timestamps are periodic
+  static void makeImplicit(Chunk& chunk);
+
+  template <typename ChunkA, typename ChunkB>
+  static bool sameTimeColumn(const ChunkA& a, const ChunkB& b)
+  {
+    if( a.implicit_x )
+    {
+      return b.implicit_x && a.t0 == b.t0 && a.dt == b.dt;
+    }
+    return a.x && a.x == b.x;
+  }
+
+  void pushBackUnchecked(const Point& p);
+
+  template <typename TimeIt, typename ValueIt>
+  void appendRange(TimeIt times, ValueIt values, size_t count);
+
+  void trimFront();
+
+  void recycleChunk(Chunk& chunk);
+
+  // give up to "count" spare chunks to other, if it can keep them
+  void giveSpareChunks(PlotDataGeneric& other, size_t count);
+
+  bool isTimeWindowed() const { return _max_range_X < std::numeric_limits<Time>::max(); }
+
+  static size_t nextGeneration()
+  {
+    static std::atomic<size_t> counter(0);
+    return ++counter;
+  }
+
+  std::deque<Chunk> _chunks;
+  // in streaming mode, evicted chunks are kept here and reused, as in a ring buffer
+  std::vector<Chunk> _spare_chunks;
+  size_t _front; // offset of the first valid sample in _chunks.front()
+  size_t _size;
   Time _max_range_X;
+
+  size_t _evicted_count; // samples removed from the front since the last clear()
+  size_t _generation;
+
+  // updated lazily by rangeY(), invalidated by direct modification of the samples
+  mutable MinMaxPyramid<Value> _minmax_index;
+  mutable size_t _minmax_end;
+  mutable bool _minmax_dirty;
+
+  // range of the entire time window, updated lazily by rangeY() when streaming
+  mutable SlidingMinMax<Value> _window_minmax;
+  mutable size_t _window_minmax_end;
+
+  // updated lazily by statistics(). It covers the samples in [_stats_end - count, _stats_end);
+  // evicted samples are removed from it as they leave, see evictFromStatistics().
+  mutable RunningStatistics _stats;
+  mutable size_t _stats_end;
+  mutable size_t _stats_evicted;
+  mutable bool _stats_dirty;
+
+  // Interpolation search is used while the score is below SEARCH_SCORE_THRESHOLD.
+  // Good guesses decrease the score, bad ones increase it: when the sampling is irregular
+  // the series switches to binary search, trying interpolation again from time to time.
+  enum { SEARCH_SCORE_THRESHOLD = 64, SEARCH_SCORE_PENALTY = 32, SEARCH_SCORE_MAX = 128,
+         SEARCH_GOOD_PROBES = 8 };
+  mutable std::atomic<int> _search_score;
 };
 
 
@@ -153,6 +790,39 @@ typedef struct{
                                    ).first;
   }
 
+  typedef size_t SeriesHandle;
+
+  // Register the numeric series once (creating it if needed) and then use the handle
+  // to access it with numericSeries(), without hashing the name again.
+  // Handles are invalidated when elements are erased from "numeric": call clearHandles().
+  SeriesHandle numericHandle(const std::string& name)
+  {
+      auto it = _numeric_handles.find(name);
+      if( it != _numeric_handles.end() )
+      {
+          return it->second;
+      }
+      const SeriesHandle handle = _numeric_by_handle.size();
+      _numeric_by_handle.push_back( &(addNumeric(name)->second) );
+      _numeric_handles.insert( {name, handle} );
+      return handle;
+  }
+
+  PlotData& numericSeries(SeriesHandle handle)
+  {
+      return *_numeric_by_handle[handle];
+  }
+
+  void clearHandles()
+  {
+      _numeric_handles.clear();
+      _numeric_by_handle.clear();
+  }
+
+private:
+  std::unordered_map<std::string, SeriesHandle> _numeric_handles;
+  std::vector<PlotData*> _numeric_by_handle;
+
 } PlotDataMapRef;
 
 
@@ -169,111 +839,956 @@ typedef struct{
 
 template<typename Time, typename Value>
 inline PlotDataGeneric<Time, Value>::PlotDataGeneric(const std::string &name):
-    _max_range_X( std::numeric_limits<Time>::max() )
+    _name(name)
     , _color_hint(Qt::black)
-    , _name(name)
+    , _front(0)
+    , _size(0)
+    , _max_range_X( std::numeric_limits<Time>::max() )
+    , _evicted_count(0)
+    , _generation( nextGeneration() )
+    , _minmax_end(0)
+    , _minmax_dirty(false)
+    , _window_minmax_end(0)
+    , _stats_end(0)
+    , _stats_evicted(0)
+    , _stats_dirty(false)
+    , _search_score(0)
 {
     static_assert( std::is_arithmetic<Time>::value ,"Only numbers can be used as time");
 }
 
 template < typename Time, typename Value>
-inline void PlotDataGeneric<Time, Value>::pushBack(Point point)
+inline typename PlotDataGeneric<Time, Value>::Chunk&
+PlotDataGeneric<Time, Value>::writableChunk()
 {
-  _points.push_back( point );
-
-  while( _points.size()>2 &&
-         (_points.back().x - _points.front().x) > _max_range_X)
+  if( _chunks.empty() || _chunks.back().count() == CHUNK_SIZE )
   {
-        _points.pop_front();
-  }
-}
-
-template <> // template specialization
-inline void PlotDataGeneric<double, double>::pushBack(Point point)
-{
-    if( std::isinf( point.y ) || std::isnan( point.y ) )
+    if( !_chunks.empty() )
     {
-        return; // skip
+      makeImplicit( _chunks.back() );
     }
-    _points.push_back( point );
-
-    while( _points.size()>2 &&
-           (_points.back().x - _points.front().x) > _max_range_X)
+    if( !_spare_chunks.empty() )
+    {
+      _chunks.push_back( std::move(_spare_chunks.back()) );
+      _spare_chunks.pop_back();
+    }
+    else
     {
-        _points.pop_front();
+      const bool first_chunk = _chunks.empty();
+      _chunks.emplace_back();
+      // let small series grow on demand, reserve the entire block otherwise
+      if( !first_chunk )
+      {
+        _chunks.back().x->reserve( CHUNK_SIZE );
+        _chunks.back().y.reserve( CHUNK_SIZE );
+      }
     }
+  }
+  return _chunks.back();
 }
 
 template < typename Time, typename Value>
-inline int PlotDataGeneric<Time, Value>::getIndexFromX(Time x ) const
+inline const typename PlotDataGeneric<Time, Value>::Chunk&
+PlotDataGeneric<Time, Value>::unpackedChunk(size_t chunk_index) const
 {
-  if( _points.size() == 0 ){
-    return -1;
+  const Chunk& chunk = _chunks[chunk_index];
+  if( chunk.packed )
+  {
+    unpackChunk( const_cast<Chunk&>(chunk) );
+  }
+  return chunk;
+}
+
+template < typename Time, typename Value>
+inline typename PlotDataGeneric<Time, Value>::Chunk&
+PlotDataGeneric<Time, Value>::unpackedChunk(size_t chunk_index)
+{
+  Chunk& chunk = _chunks[chunk_index];
+  if( chunk.packed )
+  {
+    unpackChunk( chunk );
   }
-  auto lower = std::lower_bound(_points.begin(), _points.end(), Point(x,0),
-                                [](const Point &a, const Point &b)
-                                { return a.x < b.x; } );
-  auto index = std::distance( _points.begin(), lower);
+  return chunk;
+}
 
-  if( index >= _points.size() )
+template <>
+inline void PlotDataGeneric<double, double>::unpackChunk(Chunk& chunk)
+{
+  if( !chunk.packed_x.empty() )
   {
-    return _points.size() -1;
+    chunk.x = std::make_shared<std::vector<double>>( CHUNK_SIZE );
+    GorillaCodec::decodeTimes( chunk.packed_x, CHUNK_SIZE, chunk.x->data() );
+    std::vector<uint8_t>().swap( chunk.packed_x );
   }
-  if( index < 0)
+  if( !chunk.packed_y.empty() )
   {
-    return 0;
+    chunk.y.resize( CHUNK_SIZE );
+    GorillaCodec::decodeValues( chunk.packed_y, CHUNK_SIZE, chunk.y.data() );
+    std::vector<uint8_t>().swap( chunk.packed_y );
   }
+  chunk.packed = false;
+}
 
-  if( index > 0)
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::makeImplicit(Chunk& chunk)
+{
+  if( !std::is_floating_point<Time>::value || chunk.implicit_x || !chunk.x ||
+      chunk.x.use_count() > 1 || chunk.x->size() != CHUNK_SIZE )
+  {
+    return;
+  }
+  const std::vector<Time>& x = *chunk.x;
+  const Time t0 = x.front();
+  const Time dt = ( x.back() - t0 ) / Time(CHUNK_SIZE - 1);
+  if( !(dt > 0) )
+  {
+    return;
+  }
+  // jitter allowed: a small fraction of the period, plus the rounding error of the timestamp
+  const Time tolerance = dt * Time(1e-4) +
+      Time(4) * std::numeric_limits<Time>::epsilon() * std::max( Abs(t0), Abs(x.back()) );
+  for(size_t i=1; i+1 < CHUNK_SIZE; i++)
   {
-    if( Abs( _points[index-1].x - x) < Abs( _points[index].x - x) )
+    if( Abs( x[i] - (t0 + Time(i) * dt) ) > tolerance )
     {
-      return index-1;
-    }
-    else{
-      return index;
+      return;
     }
   }
-  return index;
+  chunk.t0 = t0;
+  chunk.dt = dt;
+  chunk.implicit_x = true;
+  chunk.x.reset();
 }
 
-
 template < typename Time, typename Value>
-inline nonstd::optional<Value> PlotDataGeneric<Time, Value>::getYfromX(Time x) const
+inline size_t PlotDataGeneric<Time, Value>::compress()
 {
-  int index = getIndexFromX( x );
-  if( index == -1 )
+  return 0;
+}
+
+template <>
+inline size_t PlotDataGeneric<double, double>::compress()
+{
+  const size_t raw_bytes = CHUNK_SIZE * sizeof(double);
+  size_t saved = 0;
+  // the last chunk is still growing: skip it
+  for(size_t i=0; i+1 < _chunks.size(); i++)
   {
-    return nonstd::optional<Value>();
+    Chunk& chunk = _chunks[i];
+    if( chunk.packed )
+    {
+      continue;
+    }
+    // a time column shared with other series would not release any memory
+    if( chunk.x && chunk.x.use_count() == 1 )
+    {
+      GorillaCodec::encodeTimes( chunk.x->data(), CHUNK_SIZE, chunk.packed_x );
+      if( chunk.packed_x.size() < raw_bytes )
+      {
+        chunk.packed_x.shrink_to_fit();
+        chunk.back_x = chunk.x->back();
+        chunk.x.reset();
+        saved += raw_bytes - chunk.packed_x.size();
+      }
+      else{
+        std::vector<uint8_t>().swap( chunk.packed_x );
+      }
+    }
+    GorillaCodec::encodeValues( chunk.y.data(), CHUNK_SIZE, chunk.packed_y );
+    if( chunk.packed_y.size() < raw_bytes )
+    {
+      chunk.packed_y.shrink_to_fit();
+      std::vector<double>().swap( chunk.y );
+      saved += raw_bytes - chunk.packed_y.size();
+    }
+    else{
+      std::vector<uint8_t>().swap( chunk.packed_y );
+    }
+    chunk.packed = !chunk.packed_x.empty() || !chunk.packed_y.empty();
   }
-  return _points.at(index).y;
+  return saved;
 }
 
 template < typename Time, typename Value>
-inline const typename PlotDataGeneric<Time, Value>::Point&
-PlotDataGeneric<Time, Value>::at(size_t index) const
+inline void PlotDataGeneric<Time, Value>::decompress()
 {
-    return _points[index];
+  for(size_t i=0; i < _chunks.size(); i++)
+  {
+    unpackedChunk(i);
+  }
 }
 
 template < typename Time, typename Value>
-inline typename PlotDataGeneric<Time, Value>::Point&
+inline size_t PlotDataGeneric<Time, Value>::compressionSavings() const
+{
+  size_t saved = 0;
+  for(const Chunk& chunk: _chunks)
+  {
+    if( !chunk.packed_x.empty() ) {
+      saved += CHUNK_SIZE * sizeof(Time) - chunk.packed_x.size();
+    }
+    if( !chunk.packed_y.empty() ) {
+      saved += CHUNK_SIZE * sizeof(Value) - chunk.packed_y.size();
+    }
+  }
+  return saved;
+}
+
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::pushBackUnchecked(const Point& point)
+{
+  Chunk& chunk = writableChunk();
+  chunk.writableX().push_back( point.x );
+  chunk.y.push_back( point.y );
+  _size++;
+}
+
+template < typename Time, typename Value> template <typename TimeIt, typename ValueIt>
+inline void PlotDataGeneric<Time, Value>::appendRange(TimeIt times, ValueIt values, size_t count)
+{
+  while( count > 0 )
+  {
+    Chunk& chunk = writableChunk();
+    const size_t n = std::min( count, size_t(CHUNK_SIZE) - chunk.y.size() );
+    std::vector<Time>& chunk_x = chunk.writableX();
+    chunk_x.insert( chunk_x.end(), times,  times  + n );
+    chunk.y.insert( chunk.y.end(), values, values + n );
+    times += n;
+    values += n;
+    _size += n;
+    count -= n;
+  }
+}
+
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::trimFront()
+{
+  if( _size>2 &&
+      (timeAt(_size-1) - timeAt(0)) > _max_range_X)
+  {
+    const Time back_time = timeAt(_size-1);
+    if( back_time - timeAt(1) <= _max_range_X )
+    {
+      popFront(1); // common case: a single sample left the time window
+    }
+    else{
+      // remove in a single step everything older than the time window
+      const size_t first_inside = lowerBound( back_time - _max_range_X );
+      popFront( std::min( first_inside, _size-2 ) );
+    }
+  }
+}
+
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::recycleChunk(Chunk& chunk)
+{
+  // a ring buffer never needs more spare chunks than the ones in use
+  if( isTimeWindowed() && _spare_chunks.size() < std::max( _chunks.size(), size_t(1) ) )
+  {
+    if( chunk.packed )
+    {
+      std::vector<uint8_t>().swap( chunk.packed_x );
+      std::vector<uint8_t>().swap( chunk.packed_y );
+      chunk.packed = false;
+    }
+    chunk.implicit_x = false;
+    if( !chunk.x || chunk.x.use_count() > 1 )
+    {
+      chunk.x = std::make_shared<std::vector<Time>>();
+      chunk.x->reserve( CHUNK_SIZE );
+    }
+    chunk.x->clear();
+    chunk.y.clear();
+    _spare_chunks.push_back( std::move(chunk) );
+  }
+}
+
+template <> // template specialization
+inline bool PlotDataGeneric<double, double>::isValidValue(const double& y)
+{
+    return !std::isinf( y ) && !std::isnan( y );
+}
+
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::pushBack(Point point)
+{
+  if( !isValidValue( point.y ) )
+  {
+    return; // skip
+  }
+  pushBackUnchecked( point );
+  trimFront();
+}
+
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::pushBackBatch(const Time* times, const Value* values, size_t count)
+{
+  size_t first = 0;
+  while( first < count )
+  {
+    // append the longest sequence of valid values, then skip the invalid one
+    size_t last = first;
+    while( last < count && isValidValue( values[last] ) )
+    {
+      last++;
+    }
+    appendRange( times + first, values + first, last - first );
+    first = last + 1;
+  }
+  trimFront();
+}
+
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::appendFrom(PlotDataGeneric& other)
+{
+  if( other._size == 0 )
+  {
+    return;
+  }
+  if( _size == 0 )
+  {
+    clear();
+    const size_t moved_chunks = other._chunks.size();
+    std::swap( _chunks, other._chunks );
+    std::swap( _front, other._front );
+    std::swap( _size, other._size );
+    giveSpareChunks( other, moved_chunks );
+  }
+  else if( _chunks.back().count() == CHUNK_SIZE && other._front == 0 )
+  {
+    // the chunks are aligned: splice them
+    makeImplicit( _chunks.back() );
+    const size_t moved_chunks = other._chunks.size();
+    for(auto& chunk: other._chunks)
+    {
+      _size += chunk.count();
+      _chunks.push_back( std::move(chunk) );
+    }
+    other._chunks.clear();
+    other._size = 0;
+    giveSpareChunks( other, moved_chunks );
+  }
+  else{
+    for(size_t i=0; i < other._chunks.size(); i++)
+    {
+      Chunk& chunk = other.unpackedChunk(i);
+      const size_t first = (i == 0) ? other._front : 0;
+      appendRange( chunk.writableX().cbegin() + first,
+                   std::make_move_iterator( chunk.y.begin() + first ),
+                   chunk.y.size() - first );
+    }
+  }
+  other.clear();
+  trimFront();
+}
+
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::takeSpareChunks(PlotDataGeneric& other)
+{
+  for(auto& chunk: other._spare_chunks)
+  {
+    _spare_chunks.push_back( std::move(chunk) );
+  }
+  other._spare_chunks.clear();
+}
+
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::giveSpareChunks(PlotDataGeneric& other, size_t count)
+{
+  if( !other.isTimeWindowed() )
+  {
+    return;
+  }
+  count = std::min( count, _spare_chunks.size() );
+  for(size_t i=0; i < count; i++)
+  {
+    other._spare_chunks.push_back( std::move(_spare_chunks.back()) );
+    _spare_chunks.pop_back();
+  }
+}
+
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::reserve(size_t capacity)
+{
+  if( capacity <= _size )
+  {
+    return;
+  }
+  // capacity is expressed in slots of the chunks; the first _front slots are already consumed
+  size_t required = _front + capacity;
+  if( !_chunks.empty() )
+  {
+    required -= (_chunks.size() - 1) * CHUNK_SIZE;
+    Chunk& last = unpackedChunk( _chunks.size() - 1 );
+    const size_t last_capacity = std::min( required, size_t(CHUNK_SIZE) );
+    last.writableX().reserve( last_capacity );
+    last.y.reserve( last_capacity );
+    required -= last_capacity;
+  }
+  // the spare chunks are used in LIFO order: the smallest one must be the last
+  const size_t chunks_count = ( required + CHUNK_SIZE - 1 ) / CHUNK_SIZE;
+  if( _spare_chunks.size() < chunks_count )
+  {
+    _spare_chunks.resize( chunks_count );
+  }
+  for(size_t i=0; i < chunks_count; i++)
+  {
+    const size_t chunk_capacity = (i == 0 && (required % CHUNK_SIZE) != 0 ) ?
+                                    required % CHUNK_SIZE : size_t(CHUNK_SIZE);
+    Chunk& chunk = _spare_chunks[ _spare_chunks.size() - chunks_count + i ];
+    chunk.x->reserve( chunk_capacity );
+    chunk.y.reserve( chunk_capacity );
+  }
+}
+
+template < typename Time, typename Value> template <typename OtherValue>
+inline bool PlotDataGeneric<Time, Value>::shareTimeColumnWith(const PlotDataGeneric<Time, OtherValue>& reference)
+{
+  if( _size != reference._size || _front != reference._front )
+  {
+    return false;
+  }
+  for(size_t i=0; i < _chunks.size(); i++)
+  {
+    const auto& this_chunk  = unpackedChunk(i);
+    const auto& other_chunk = reference.unpackedChunk(i);
+    if( sameTimeColumn( this_chunk, other_chunk ) )
+    {
+      continue;
+    }
+    for(size_t k = (i == 0) ? _front : 0; k < this_chunk.y.size(); k++)
+    {
+      if( this_chunk.time(k) != other_chunk.time(k) )
+      {
+        return false;
+      }
+    }
+  }
+  for(size_t i=0; i < _chunks.size(); i++)
+  {
+    const auto& other_chunk = reference._chunks[i];
+    _chunks[i].x = other_chunk.x;
+    _chunks[i].implicit_x = other_chunk.implicit_x;
+    _chunks[i].t0 = other_chunk.t0;
+    _chunks[i].dt = other_chunk.dt;
+  }
+  return true;
+}
+
+template < typename Time, typename Value> template <typename OtherValue>
+inline bool PlotDataGeneric<Time, Value>::isTimeColumnSharedWith(const PlotDataGeneric<Time, OtherValue>& other) const
+{
+  if( _size != other._size || _front != other._front )
+  {
+    return false;
+  }
+  for(size_t i=0; i < _chunks.size(); i++)
+  {
+    if( !sameTimeColumn( _chunks[i], other._chunks[i] ) )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::popFront()
+{
+  popFront(1);
+}
+
+template < typename Time, typename Value>
+inline void PlotDataGeneric<Time, Value>::popFront(size_t count)
+{
+  if( count >= _size )
+  {
+    clear();
+    return;
+  }
+  evictFromStatistics( count );
+  _front += count;
+  _size -= count;
+  _evicted_count += count;
+  while( _front >= CHUNK_SIZE )
+  {
+    recycleChunk( _chunks.front() );
+    _chunks.pop_front();
+    _front -= CHUNK_SIZE;
+  }
+}
+
+template < typename Time, typename Value>
+inline size_t PlotDataGeneric<Time, Value>::lowerBound(Time x) const
+{
+  int score = _search_score.load( std::memory_order_relaxed );
+  if( score >= SEARCH_SCORE_THRESHOLD )
+  {
+    _search_score.store( score - 1, std::memory_order_relaxed );
+    return binarySearch( x );
+  }
+  size_t probes = 0;
+  const size_t index = interpolationSearch( x, probes );
+  if( probes <= SEARCH_GOOD_PROBES ) {
+    score = std::max( score - 1, 0 );
+  }
+  else{
+    score = std::min( score + SEARCH_SCORE_PENALTY, int(SEARCH_SCORE_MAX) );
+  }
+  _search_score.store( score, std::memory_order_relaxed );
+  return index;
+}
+
+template < typename Time, typename Value>
+inline size_t PlotDataGeneric<Time, Value>::binarySearch(Time x) const
+{
+  // find the chunk first, then search inside its contiguous time column
+  auto chunk_it = std::lower_bound(_chunks.begin(), _chunks.end(), x,
+                                   [](const Chunk& chunk, Time t)
+                                   { return chunk.back() < t; } );
+  if( chunk_it == _chunks.end() )
+  {
+    return _size;
+  }
+  const size_t chunk_index = std::distance( _chunks.begin(), chunk_it );
+  const Chunk& chunk = unpackedChunk( chunk_index );
+  const size_t first = ( chunk_index == 0 ? _front : 0 );
+  const size_t last  = chunk.y.size();
+  size_t lower = first;
+
+  if( chunk.implicit_x )
+  {
+    // periodic timestamps: compute the index, then fix the rounding errors
+    const Time k = std::ceil( (x - chunk.t0) / chunk.dt );
+    lower = size_t( std::min( std::max( k, Time(first) ), Time(last) ) );
+    while( lower > first && chunk.time(lower-1) >= x ) lower--;
+    while( lower < last  && chunk.time(lower) < x ) lower++;
+  }
+  else{
+    const Time* data = chunk.x->data();
+    lower = size_t( std::lower_bound( data + first, data + last, x ) - data );
+  }
+  return (chunk_index << CHUNK_BITS) + lower - _front;
+}
+
+template < typename Time, typename Value>
+inline size_t PlotDataGeneric<Time, Value>::interpolationSearch(Time x, size_t& probes) const
+{
+  if( _size == 0 || !(x > timeAt(0)) )
+  {
+    return 0;
+  }
+  const Time t_first = timeAt(0);
+  const Time t_last = timeAt(_size-1);
+  probes += 2;
+  if( x > t_last )
+  {
+    return _size;
+  }
+  // here t_first < x <= t_last, therefore the ratio is in (0, 1]
+  const double ratio = double(x - t_first) / double(t_last - t_first);
+  const size_t guess = std::min( size_t( ratio * double(_size-1) ), _size-1 );
+  return gallopingSearch( x, guess, probes );
+}
+
+template < typename Time, typename Value>
+inline size_t PlotDataGeneric<Time, Value>::lowerBound(Time x, Cursor& cursor) const
+{
+  size_t probes = 0;
+  cursor._index = gallopingSearch( x, std::min( cursor._index, _size ), probes );
+  return cursor._index;
+}
+
+template < typename Time, typename Value>
+inline size_t PlotDataGeneric<Time, Value>::gallopingSearch(Time x, size_t start,
+                                                             size_t& probes) const
+{
+  // find an interval [lo, hi] that contains the lower bound, doubling the step
+  // at each iteration, then use a binary search inside it.
+  size_t lo = 0;
+  size_t hi = _size;
+
+  probes++;
+  if( start < _size && timeAt(start) < x )
+  {
+    lo = start + 1;
+    for(size_t step = 1; ; step *= 2)
+    {
+      const size_t probe = start + step;
+      if( probe >= _size ) {
+        break;
+      }
+      probes++;
+      if( timeAt(probe) >= x ) {
+        hi = probe;
+        break;
+      }
+      lo = probe + 1;
+    }
+  }
+  else{
+    hi = start;
+    for(size_t step = 1; ; step *= 2)
+    {
+      if( step > start ) {
+        break;
+      }
+      const size_t probe = start - step;
+      probes++;
+      if( timeAt(probe) < x ) {
+        lo = probe + 1;
+        break;
+      }
+      hi = probe;
+    }
+  }
+  // the lower bound is in [lo, hi]
+  while( lo < hi )
+  {
+    const size_t mid = lo + (hi - lo) / 2;
+    probes++;
+    if( timeAt(mid) < x ) {
+      lo = mid + 1;
+    }
+    else{
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+template < typename Time, typename Value>
+inline size_t PlotDataGeneric<Time, Value>::upperBound(Time x) const
+{
+  // skip the samples equal to x, if any, with steps of increasing size
+  size_t lo = lowerBound( x );
+  size_t hi = lo;
+  for(size_t step = 1; hi < _size && timeAt(hi) <= x; step *= 2)
+  {
+    lo = hi + 1;
+    hi = std::min( hi + step, _size );
+  }
+  // the upper bound is in [lo, hi]
+  while( lo < hi )
+  {
+    const size_t mid = lo + (hi - lo) / 2;
+    if( timeAt(mid) <= x ) {
+      lo = mid + 1;
+    }
+    else{
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+template < typename Time, typename Value>
+inline std::vector<typename PlotDataGeneric<Time, Value>::Span>
+PlotDataGeneric<Time, Value>::spans(size_t first_index, size_t last_index) const
+{
+  std::vector<Span> result;
+  last_index = std::min( last_index, _size );
+  size_t index = first_index;
+  while( index < last_index )
+  {
+    const size_t pos = _front + index;
+    const Chunk& chunk = unpackedChunk( pos >> CHUNK_BITS );
+    const size_t offset = pos & CHUNK_MASK;
+    const size_t count = std::min( chunk.y.size() - offset, last_index - index );
+    Span span;
+    span._x = chunk.implicit_x ? nullptr : chunk.x->data() + offset;
+    span._y = chunk.y.data() + offset;
+    span._t0 = chunk.t0;
+    span._dt = chunk.dt;
+    span._offset = offset;
+    span._count = count;
+    span._first_index = index;
+    result.push_back( span );
+    index += count;
+  }
+  return result;
+}
+
+template < typename Time, typename Value>
+inline std::vector<typename PlotDataGeneric<Time, Value>::Span>
+PlotDataGeneric<Time, Value>::spansInRange(Time t_min, Time t_max) const
+{
+  if( t_max < t_min )
+  {
+    return std::vector<Span>();
+  }
+  return spans( lowerBound( t_min ), upperBound( t_max ) );
+}
+
+template < typename Time, typename Value>
+inline int PlotDataGeneric<Time, Value>::nearestIndex(Time x, size_t index) const
+{
+  if( _size == 0 ){
+    return -1;
+  }
+  if( index >= _size )
+  {
+    return _size -1;
+  }
+
+  if( index > 0)
+  {
+    if( Abs( timeAt(index-1) - x) < Abs( timeAt(index) - x) )
+    {
+      return index-1;
+    }
+    else{
+      return index;
+    }
+  }
+  return index;
+}
+
+template < typename Time, typename Value>
+inline int PlotDataGeneric<Time, Value>::getIndexFromX(Time x ) const
+{
+  return nearestIndex( x, lowerBound( x ) );
+}
+
+template < typename Time, typename Value>
+inline int PlotDataGeneric<Time, Value>::getIndexFromX(Time x, Cursor& cursor) const
+{
+  return nearestIndex( x, lowerBound( x, cursor ) );
+}
+
+template < typename Time, typename Value>
+inline nonstd::optional<Value> PlotDataGeneric<Time, Value>::getYfromX(Time x) const
+{
+  int index = getIndexFromX( x );
+  if( index == -1 )
+  {
+    return nonstd::optional<Value>();
+  }
+  return at(index).y;
+}
+
+template < typename Time, typename Value>
+inline nonstd::optional<Value> PlotDataGeneric<Time, Value>::getYfromX(Time x, Cursor& cursor) const
+{
+  int index = getIndexFromX( x, cursor );
+  if( index == -1 )
+  {
+    return nonstd::optional<Value>();
+  }
+  return at(index).y;
+}
+
+template < typename Time, typename Value>
+inline typename PlotDataGeneric<Time, Value>::ConstPointRef
+PlotDataGeneric<Time, Value>::at(size_t index) const
+{
+    const size_t pos = index + _front;
+    const Chunk& chunk = unpackedChunk( pos >> CHUNK_BITS );
+    return ConstPointRef( chunk.time( pos & CHUNK_MASK ), chunk.y[ pos & CHUNK_MASK ] );
+}
+
+template < typename Time, typename Value>
+inline typename PlotDataGeneric<Time, Value>::PointRef
 PlotDataGeneric<Time, Value>::at(size_t index)
 {
-    return _points[index];
+    _minmax_dirty = true;
+    _stats_dirty = true;
+    _generation = nextGeneration();
+    const size_t pos = index + _front;
+    Chunk& chunk = unpackedChunk( pos >> CHUNK_BITS );
+    return PointRef( chunk.writableX()[ pos & CHUNK_MASK ], chunk.y[ pos & CHUNK_MASK ] );
+}
+
+template < typename Time, typename Value>
+inline Time PlotDataGeneric<Time, Value>::timeAt(size_t index) const
+{
+    const size_t pos = index + _front;
+    return unpackedChunk( pos >> CHUNK_BITS ).time( pos & CHUNK_MASK );
+}
+
+template < typename Time, typename Value>
+inline const Value& PlotDataGeneric<Time, Value>::valueAt(size_t index) const
+{
+    const size_t pos = index + _front;
+    return unpackedChunk( pos >> CHUNK_BITS ).y[ pos & CHUNK_MASK ];
+}
+
+template < typename Time, typename Value>
+inline typename PlotDataGeneric<Time, Value>::RangeValueOpt
+PlotDataGeneric<Time, Value>::rangeY(size_t first_index, size_t last_index) const
+{
+    last_index = std::min( last_index, _size );
+    if( first_index >= last_index )
+    {
+        return RangeValueOpt();
+    }
+    const size_t offset = _evicted_count;
+
+    if( _minmax_dirty )
+    {
+        _minmax_index.clear();
+        _minmax_end = offset;
+        _window_minmax.clear();
+        _window_minmax_end = offset;
+        _minmax_dirty = false;
+    }
+
+    // streaming: the range of the entire window is what the autoscale asks for, every frame
+    if( isTimeWindowed() && first_index == 0 && last_index == _size )
+    {
+        if( _window_minmax_end < offset )
+        {
+            _window_minmax.clear();
+            _window_minmax_end = offset;
+        }
+        _window_minmax.evictBefore( offset );
+        for(const Span& span: spans( _window_minmax_end - offset, _size ))
+        {
+            for(size_t i=0; i < span.size(); i++)
+            {
+                _window_minmax.push( _window_minmax_end++, span.value(i) );
+            }
+        }
+        return RangeValueOpt( { _window_minmax.min(), _window_minmax.max() } );
+    }
+
+    // bring the index up to date with the samples added or removed since the last call
+    if( _minmax_end < offset )
+    {
+        _minmax_index.clear();
+        _minmax_end = offset;
+    }
+    _minmax_index.evictBefore( offset );
+    for(const Span& span: spans( _minmax_end - offset, _size ))
+    {
+        for(size_t i=0; i < span.size(); i++)
+        {
+            _minmax_index.push( _minmax_end++, span.value(i) );
+        }
+    }
+
+    auto range = _minmax_index.range( offset + first_index, offset + last_index,
+                                      [this, offset](size_t pos) -> const Value&
+                                      { return valueAt(pos - offset); } );
+    return RangeValueOpt( { range.min, range.max } );
+}
+
+template<typename Time, typename Value>
+inline typename PlotDataGeneric<Time, Value>::Statistics
+PlotDataGeneric<Time, Value>::statistics() const
+{
+    const size_t offset = _evicted_count;
+
+    // start from scratch if the samples were modified, or if the evicted samples
+    // removed so far are many enough to accumulate rounding errors
+    if( _stats_dirty || _stats_end - _stats.count() != offset || _stats_evicted > _size )
+    {
+        _stats.clear();
+        _stats_end = offset;
+        _stats_evicted = 0;
+        _stats_dirty = false;
+    }
+    for(const Span& span: spans( _stats_end - offset, _size ))
+    {
+        for(size_t i=0; i < span.size(); i++)
+        {
+            _stats.add( double(span.value(i)) );
+        }
+        _stats_end += span.size();
+    }
+
+    Statistics stats;
+    stats.count = _size;
+    stats.mean = _stats.mean();
+    stats.variance = _stats.variance();
+    const auto range = rangeY( 0, _size );
+    stats.min = range ? range->min : Value();
+    stats.max = range ? range->max : Value();
+    return stats;
+}
+
+template <> // template specialization
+inline void PlotDataGeneric<double, double>::evictFromStatistics(size_t count)
+{
+    const size_t offset = _evicted_count;
+    if( _stats_dirty || _stats.count() == 0 || _stats_end - _stats.count() != offset )
+    {
+        return; // statistics() will start from scratch anyway
+    }
+    count = std::min( count, _stats_end - offset );
+    for(size_t i=0; i < count; i++)
+    {
+        _stats.remove( valueAt(i) );
+    }
+    _stats_evicted += count;
 }
 
 template<typename Time, typename Value>
 void PlotDataGeneric<Time, Value>::clear()
 {
-    _points.clear();
+    for(auto& chunk: _chunks)
+    {
+        recycleChunk( chunk );
+    }
+    _chunks.clear();
+    _front = 0;
+    _size = 0;
+    _evicted_count = 0;
+    _minmax_index.clear();
+    _minmax_end = 0;
+    _minmax_dirty = false;
+    _window_minmax.clear();
+    _window_minmax_end = 0;
+    _stats.clear();
+    _stats_end = 0;
+    _stats_evicted = 0;
+    _stats_dirty = false;
+    _search_score.store( 0, std::memory_order_relaxed );
+    _generation = nextGeneration();
 }
 
+template<typename Time, typename Value>
+void PlotDataGeneric<Time, Value>::resize(size_t new_size)
+{
+    _minmax_dirty = true;
+    _stats_dirty = true;
+    _generation = nextGeneration();
+    if( new_size == 0 )
+    {
+        clear();
+        return;
+    }
+    while( _size > new_size )
+    {
+        Chunk& chunk = unpackedChunk( _chunks.size() - 1 );
+        const size_t first_valid = ( _chunks.size() == 1 ) ? _front : 0;
+        const size_t to_remove = std::min( chunk.y.size() - first_valid, _size - new_size );
+        chunk.writableX().resize( chunk.y.size() - to_remove );
+        chunk.y.resize( chunk.y.size() - to_remove );
+        _size -= to_remove;
+        if( chunk.y.size() == first_valid )
+        {
+            _chunks.pop_back();
+        }
+    }
+    while( _size < new_size )
+    {
+        if( _chunks.empty() || _chunks.back().count() == CHUNK_SIZE )
+        {
+            _chunks.emplace_back();
+        }
+        Chunk& chunk = _chunks.back();
+        const size_t to_add = std::min( CHUNK_SIZE - chunk.y.size(), new_size - _size );
+        chunk.writableX().resize( chunk.y.size() + to_add );
+        chunk.y.resize( chunk.y.size() + to_add );
+        _size += to_add;
+    }
+}
 
 template < typename Time, typename Value>
 inline size_t PlotDataGeneric<Time, Value>::size() const
 {
-  return _points.size();
+  return _size;
 }
 
 template < typename Time, typename Value>
@@ -293,10 +1808,26 @@ template < typename Time, typename Value>
 inline void PlotDataGeneric<Time, Value>::setMaximumRangeX(Time max_range)
 {
   _max_range_X = max_range;
-  while( _points.size()>2 &&
-         _points.back().x - _points.front().x > _max_range_X)
+  trimFront();
+
+  if( !isTimeWindowed() )
   {
-        _points.pop_front();
+    // not streaming anymore
+    std::vector<Chunk>().swap( _spare_chunks );
+  }
+  else if( _size > 1 && timeAt(_size-1) > timeAt(0) )
+  {
+    // preallocate the chunks required by an entire time window at the current rate
+    const double rate = double(_size - 1) / double( timeAt(_size-1) - timeAt(0) );
+    const double expected = std::min( rate * double(_max_range_X), double(MAX_CAPACITY) );
+    const size_t needed_chunks = ( size_t(expected) + _front ) / CHUNK_SIZE + 1;
+
+    _spare_chunks.resize( std::max( needed_chunks, _chunks.size() ) - _chunks.size() );
+    for(auto& chunk: _spare_chunks)
+    {
+      chunk.x->reserve( CHUNK_SIZE );
+      chunk.y.reserve( CHUNK_SIZE );
+    }
   }
 }
 
@@ -0,0 +1,86 @@
+#ifndef PJ_SPSC_QUEUE_H
+#define PJ_SPSC_QUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief Bounded, lock-free queue with a Single Producer and a Single Consumer.
+ *
+ * push() must be called always by the same thread. pop() must not be called by
+ * more threads at the same time: if it is, they must be serialized by a mutex.
+ * Neither of them ever blocks: push() returns false when the queue is full
+ * and pop() returns false when it is empty.
+ */
+template <typename T>
+class SPSCQueue
+{
+  static const size_t CACHE_LINE_SIZE = 64;
+
+public:
+
+  // capacity is rounded up to the next power of two
+  explicit SPSCQueue(size_t capacity = 1024):
+    _head(0),
+    _tail(0)
+  {
+    size_t size = 2;
+    while( size < capacity ) {
+      size *= 2;
+    }
+    _buffer.resize( size );
+    _mask = size - 1;
+  }
+
+  SPSCQueue(const SPSCQueue&) = delete;
+  SPSCQueue& operator = (const SPSCQueue&) = delete;
+
+  size_t capacity() const { return _buffer.size(); }
+
+  // Producer side. The element is moved only if there is room for it.
+  bool push(T& item)
+  {
+    const size_t tail = _tail.load( std::memory_order_relaxed );
+    if( tail - _head.load( std::memory_order_acquire ) >= _buffer.size() )
+    {
+      return false;
+    }
+    _buffer[ tail & _mask ] = std::move( item );
+    _tail.store( tail + 1, std::memory_order_release );
+    return true;
+  }
+
+  // Consumer side.
+  bool pop(T& item)
+  {
+    const size_t head = _head.load( std::memory_order_relaxed );
+    if( head == _tail.load( std::memory_order_acquire ) )
+    {
+      return false;
+    }
+    item = std::move( _buffer[ head & _mask ] );
+    _head.store( head + 1, std::memory_order_release );
+    return true;
+  }
+
+  // Approximated when called concurrently with push() or pop().
+  bool empty() const
+  {
+    return _head.load( std::memory_order_acquire ) == _tail.load( std::memory_order_acquire );
+  }
+
+private:
+  std::vector<T> _buffer;
+  size_t _mask;
+  // head and tail are written by different threads: keep them in different cache lines.
+  // Padding is used instead of alignas(64), because before C++17 operator new does not
+  // respect the alignment of over-aligned types (the streamers are allocated with new).
+  char _padding_head[CACHE_LINE_SIZE];
+  std::atomic<size_t> _head;
+  char _padding_tail[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> _tail;
+};
+
+#endif // PJ_SPSC_QUEUE_H
@@ -0,0 +1,171 @@
+#ifndef PJ_TIME_JOIN_H
+#define PJ_TIME_JOIN_H
+
+#include <vector>
+#include <algorithm>
+#include "PlotJuggler/plotdata.h"
+
+/**
+ * @brief Aligns several series on common timestamps (k-way merge join).
+ *
+ * The rows are the union of the timestamps of all the series (their intersection in
+ * EXACT mode), in increasing order. Each row has one value for each series, computed
+ * according to the Mode. The series are scanned once, in a single linear pass.
+ *
+ * Rows are produced only where every series has a value:
+ * - from the latest first sample to the earliest last sample (EXACT, NEAREST, LINEAR);
+ * - from the latest first sample to the latest last sample (ZERO_ORDER_HOLD).
+ *
+ * When a series has more samples with the same timestamp, the last one is used.
+ * The series must not be modified while the join is used.
+ */
+template <typename Time, typename Value>
+class TimeAlignedJoinGeneric
+{
+public:
+
+  enum Mode{
+    EXACT,           // only the timestamps present in all the series
+    NEAREST,         // value of the sample closest in time
+    ZERO_ORDER_HOLD, // value of the last sample at or before the row time
+    LINEAR           // linear interpolation of the samples around the row time
+  };
+
+  typedef PlotDataGeneric<Time, Value> Series;
+
+  TimeAlignedJoinGeneric(const std::vector<const Series*>& series, Mode mode);
+
+  // Move to the next row. Return false when there are no more rows.
+  bool next();
+
+  Time time() const { return _time; }
+
+  // one value for each series, in the same order passed to the constructor
+  const std::vector<Value>& values() const { return _values; }
+
+private:
+  Value valueAt(size_t k) const;
+
+  std::vector<const Series*> _series;
+  Mode _mode;
+  // index of the first sample of each series that was not consumed yet
+  std::vector<size_t> _pos;
+  Time _time;
+  Time _end_time;
+  bool _done;
+  std::vector<Value> _values;
+};
+
+typedef TimeAlignedJoinGeneric<double, double> TimeAlignedJoin;
+
+//-----------------------------------
+
+template <typename Time, typename Value>
+inline TimeAlignedJoinGeneric<Time, Value>::TimeAlignedJoinGeneric(const std::vector<const Series*>& series,
+                                                                   Mode mode):
+  _series(series),
+  _mode(mode),
+  _pos(series.size(), 0),
+  _time(),
+  _end_time(),
+  _done(series.empty()),
+  _values(series.size())
+{
+  for(const Series* s: _series)
+  {
+    _done = _done || s->size() == 0;
+  }
+  if( _done )
+  {
+    return;
+  }
+
+  Time start_time = _series.front()->front().x;
+  _end_time = _series.front()->back().x;
+  for(const Series* s: _series)
+  {
+    start_time = std::max( start_time, s->front().x );
+    _end_time = ( mode == ZERO_ORDER_HOLD ) ? std::max( _end_time, s->back().x ) :
+                                              std::min( _end_time, s->back().x );
+  }
+  for(size_t k=0; k < _series.size(); k++)
+  {
+    _pos[k] = _series[k]->lowerBound( start_time );
+  }
+}
+
+template <typename Time, typename Value>
+inline bool TimeAlignedJoinGeneric<Time, Value>::next()
+{
+  while( !_done )
+  {
+    // the time of the row is the oldest sample not consumed yet
+    bool found = false;
+    Time t = Time();
+    for(size_t k=0; k < _series.size(); k++)
+    {
+      if( _pos[k] < _series[k]->size() )
+      {
+        const Time sample_time = _series[k]->at( _pos[k] ).x;
+        if( !found || sample_time < t )
+        {
+          t = sample_time;
+          found = true;
+        }
+      }
+    }
+    if( !found || t > _end_time )
+    {
+      _done = true;
+      return false;
+    }
+
+    size_t matches = 0;
+    for(size_t k=0; k < _series.size(); k++)
+    {
+      const Series& s = *_series[k];
+      bool match = false;
+      while( _pos[k] < s.size() && !(t < s.at( _pos[k] ).x) )
+      {
+        _pos[k]++;
+        match = true;
+      }
+      matches += match ? 1 : 0;
+    }
+    if( _mode == EXACT && matches < _series.size() )
+    {
+      continue;
+    }
+
+    _time = t;
+    for(size_t k=0; k < _series.size(); k++)
+    {
+      _values[k] = valueAt(k);
+    }
+    return true;
+  }
+  return false;
+}
+
+template <typename Time, typename Value>
+inline Value TimeAlignedJoinGeneric<Time, Value>::valueAt(size_t k) const
+{
+  // the rows start from the latest first sample: there is always a sample before _time
+  const Series& s = *_series[k];
+  const size_t pos = _pos[k];
+  const auto before = s.at( pos - 1 );
+
+  if( _mode == EXACT || _mode == ZERO_ORDER_HOLD || pos == s.size() || !(before.x < _time) )
+  {
+    return before.y;
+  }
+  const auto after = s.at( pos );
+  if( _mode == NEAREST )
+  {
+    return ( after.x - _time < _time - before.x ) ? after.y : before.y;
+  }
+  const double ratio = double( _time - before.x ) / double( after.x - before.x );
+  return before.y + Value( ratio * ( after.y - before.y ) );
+}
+
+#endif // PJ_TIME_JOIN_H
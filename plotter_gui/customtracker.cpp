@@ -1,4 +1,5 @@
 #include "customtracker.h"
+#include "series_data.h"
 #include "qwt_series_data.h"
 #include "qwt_plot.h"
 #include "qwt_plot_curve.h"
@@ -153,6 +154,16 @@ void CurveTracker::setPosition(const QPointF& position)
 
                 line = QString( "<font color=%1>%2 : %3</font>" )
                         .arg( color.name() ).arg( value ).arg(curve->title().text() );
+
+                auto series = dynamic_cast<const DataSeriesBase*>( curve->data() );
+                if( series )
+                {
+                    const auto stats = series->transformedData()->statistics();
+                    line += QString( "<font color=%1> (mean %2, std dev %3)</font>" )
+                            .arg( color.name() )
+                            .arg( QString::number( stats.mean, 'f', 3) )
+                            .arg( QString::number( stats.stddev(), 'f', 3) );
+                }
             }
 
             text_lines.insert( std::make_pair(val, line) );
@@ -0,0 +1,80 @@
+#include "decimated_curve.h"
+#include "timeseries_qwt.h"
+#include "qwt_clipper.h"
+#include "qwt_painter.h"
+#include "qwt_scale_map.h"
+#include <QPainter>
+#include <cmath>
+
+void DecimatedCurve::drawLines(QPainter *painter,
+                               const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+                               const QRectF &canvasRect, int from, int to) const
+{
+    const auto series = dynamic_cast<const TimeseriesQwt*>( data() );
+
+    if( !series || testCurveAttribute( Fitted ) ||
+        from != 0 || to + 1 != static_cast<int>( dataSize() ) )
+    {
+        QwtPlotCurve::drawLines(painter, xMap, yMap, canvasRect, from, to);
+        return;
+    }
+
+    const PlotData* plot_data = series->transformedData();
+    const double offset = series->timeOffset();
+
+    double t_min = xMap.invTransform( canvasRect.left() )  + offset;
+    double t_max = xMap.invTransform( canvasRect.right() ) + offset;
+    if( t_min > t_max ) std::swap(t_min, t_max);
+
+    // visible samples, plus one on each side to draw the lines that leave the canvas
+    size_t first = plot_data->lowerBound( t_min );
+    size_t last  = plot_data->lowerBound( t_max );
+    if( first > 0 ) first--;
+    last = std::min( last + 1, plot_data->size() );
+
+    QPolygonF polyline;
+    polyline.reserve( 4 * static_cast<int>( canvasRect.width() + 4) );
+
+    auto appendSample = [&](size_t index)
+    {
+        const auto p = plot_data->at(index);
+        polyline.append( QPointF( xMap.transform( p.x - offset ),
+                                  yMap.transform( p.y ) ) );
+    };
+
+    size_t index = first;
+    while( index < last )
+    {
+        // all the samples that fall in the same pixel column of this one
+        const double column = std::floor( xMap.transform( plot_data->timeAt(index) - offset ) );
+        const double column_end_time = xMap.invTransform( column + 1.0 ) + offset;
+        const size_t next = std::min( last, std::max( index + 1, plot_data->lowerBound( column_end_time ) ) );
+
+        appendSample( index );
+        if( next - index > 2 )
+        {
+            const auto range = plot_data->rangeY( index+1, next-1 );
+            polyline.append( QPointF( column, yMap.transform( range->min ) ) );
+            polyline.append( QPointF( column, yMap.transform( range->max ) ) );
+        }
+        if( next - index > 1 )
+        {
+            appendSample( next - 1 );
+        }
+        index = next;
+    }
+
+    if( testPaintAttribute( ClipPolygons ) )
+    {
+        QRectF clip_rect = canvasRect;
+        if( painter->hasClipping() )
+        {
+            clip_rect &= painter->clipBoundingRect();
+        }
+        const qreal pw = qMax( qreal( 1.0 ), painter->pen().widthF() );
+        clip_rect = clip_rect.adjusted( -pw, -pw, pw, pw );
+        QwtClipper::clipPolygonF( clip_rect, polyline, false );
+    }
+
+    QwtPainter::drawPolyline( painter, polyline );
+}
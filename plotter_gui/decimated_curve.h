@@ -0,0 +1,27 @@
+#ifndef DECIMATED_CURVE_H
+#define DECIMATED_CURVE_H
+
+#include "qwt_plot_curve.h"
+
+/**
+ * @brief QwtPlotCurve that draws the lines of a time series using at most
+ * 4 points for each pixel column (first, min, max and last sample), i.e. M4 decimation.
+ *
+ * The cost of drawing is proportional to the width of the canvas, instead of the
+ * number of samples, and the result is visually equivalent to drawing all of them.
+ * Series that are not a TimeseriesQwt are drawn as usual.
+ */
+class DecimatedCurve: public QwtPlotCurve
+{
+public:
+    explicit DecimatedCurve(const QString &title = QString()):
+        QwtPlotCurve(title)
+    {}
+
+protected:
+    virtual void drawLines( QPainter *painter,
+                            const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+                            const QRectF &canvasRect, int from, int to ) const override;
+};
+
+#endif // DECIMATED_CURVE_H
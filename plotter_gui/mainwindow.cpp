@@ -19,6 +19,7 @@
 #include <QPushButton>
 #include <QScrollBar>
 #include <QSettings>
+#include <QStatusBar>
 #include <QStringListModel>
 #include <QStringRef>
 #include <QThread>
@@ -129,6 +130,11 @@ MainWindow::MainWindow(const QCommandLineParser &commandline_parser, QWidget *pa
     _publish_timer->setInterval(20);
     connect(_publish_timer, &QTimer::timeout, this, &MainWindow::publishPeriodically );
 
+    _compress_timer = new QTimer(this);
+    _compress_timer->setInterval(5000);
+    connect(_compress_timer, &QTimer::timeout, this, &MainWindow::compressUnusedData );
+    _compress_timer->start();
+
 
     ui->menuFile->setToolTipsVisible(true);
     ui->horizontalSpacer->changeSize(0,0, QSizePolicy::Fixed, QSizePolicy::Fixed);
@@ -294,7 +300,7 @@ void MainWindow::onUpdateLeftTableValues()
 
                     if( _tracker_time < std::numeric_limits<double>::max())
                     {
-                        auto value = data.getYfromX( _tracker_time );
+                        auto value = data.getYfromX( _tracker_time, _tracker_cursors[name] );
                         if(value){
                             valid = true;
                             num = value.value();
@@ -321,6 +327,11 @@ void MainWindow::onUpdateLeftTableValues()
                         }
                         table_model->item(row,1)->setText(num_text + ' ');
                     }
+                    const auto stats = data.statistics();
+                    table_model->item(row,1)->setToolTip(
+                                QString("samples: %1\nmin: %2\nmax: %3\nmean: %4\nstd dev: %5")
+                                .arg( stats.count ).arg( stats.min ).arg( stats.max )
+                                .arg( stats.mean ).arg( stats.stddev() ) );
                     // table_model->item(row,1)->setText(num_text + ' ');
                 }
             }
@@ -1137,15 +1148,42 @@ void importPlotDataMapHelper(std::unordered_map<std::string,T>& source,
         }
         else
         {
-            for (size_t i=0; i< source_plot.size(); i++)
-            {
-                destination_plot.pushBack( source_plot.at(i) );
-            }
+            // moves whole chunks when possible and leaves source_plot empty
+            destination_plot.appendFrom( source_plot );
         }
         source_plot.clear();
     }
 }
 
+template <typename T>
+void takeStreamerDataHelper(std::unordered_map<std::string,T>& source,
+                            std::unordered_map<std::string,T>& destination)
+{
+    for (auto& it: source)
+    {
+        const std::string& name  = it.first;
+        auto staged = destination.find(name);
+        if( staged == destination.end() )
+        {
+            staged = destination.emplace( std::piecewise_construct,
+                                          std::forward_as_tuple(name),
+                                          std::forward_as_tuple(name)
+                                          ).first;
+        }
+        // With the same time window, the staged series keeps the chunks emptied by
+        // importPlotDataMap() as spare ones, that go back to the streamer below.
+        // Otherwise, the streamer would allocate new chunks at every update.
+        if( staged->second.maximumRangeX() != it.second.maximumRangeX() )
+        {
+            staged->second.setMaximumRangeX( it.second.maximumRangeX() );
+        }
+        // the staged series is always empty here: swapping only exchanges
+        // the chunk containers, independently of the number of samples
+        staged->second.swapData( it.second );
+        it.second.takeSpareChunks( staged->second );
+    }
+}
+
 void MainWindow::deleteAllDataImpl()
 {
     forEachWidget( [](PlotWidget* plot) {
@@ -1154,6 +1192,7 @@ void MainWindow::deleteAllDataImpl()
     _mapped_plot_data.numeric.clear();
     _mapped_plot_data.user_defined.clear();
     _custom_plots.clear();
+    _tracker_cursors.clear();
     _curvelist_widget->clear();
 
     bool stopped = false;
@@ -1380,6 +1419,7 @@ void MainWindow::onActionLoadStreamer(QString streamer_name)
     {
         {
             std::lock_guard<std::mutex> lock( _current_streamer->mutex() );
+            _current_streamer->consumeQueuedBatches();
             importPlotDataMap( _current_streamer->dataMap(), true );
         }
 
@@ -1635,9 +1675,15 @@ void MainWindow::onActionLoadLayoutFromFile(QString filename)
                 CustomPlotPtr new_custom_plot = CustomFunction::createFromXML(custom_eq);
                 const auto& name = new_custom_plot->name();
                 _custom_plots[name] = new_custom_plot;
-                new_custom_plot->calculateAndAdd( _mapped_plot_data );
+                auto data_it = _mapped_plot_data.numeric.find( name );
+                if( data_it != _mapped_plot_data.numeric.end() )
+                {
+                    data_it->second.clear();
+                }
                 _curvelist_widget->addItem( QString::fromStdString( name ) );
             }
+            // a custom plot can read others, saved later in the layout
+            _custom_plots_graph.update( _custom_plots, _mapped_plot_data );
             _curvelist_widget->refreshColumns();
         }
     }
@@ -1897,14 +1943,19 @@ void MainWindow::updateDataAndReplot(bool replot_hidden_tabs)
 {
     if( _current_streamer )
     {
-        std::lock_guard<std::mutex> lock( _current_streamer->mutex() );
-        importPlotDataMap( _current_streamer->dataMap(), false );
-
-        for( auto& custom_it: _custom_plots)
         {
-            auto* dst_plot = &_mapped_plot_data.numeric.at(custom_it.first);
-            custom_it.second->calculate(_mapped_plot_data, dst_plot);
+            // keep the critical section short: the samples are moved to the staging
+            // map here and imported into _mapped_plot_data once the lock is released
+            std::lock_guard<std::mutex> lock( _current_streamer->mutex() );
+            _current_streamer->consumeQueuedBatches();
+            PlotDataMapRef& streamer_data = _current_streamer->dataMap();
+            takeStreamerDataHelper( streamer_data.user_defined, _streamer_staging_data.user_defined );
+            takeStreamerDataHelper( streamer_data.numeric, _streamer_staging_data.numeric );
         }
+
+        importPlotDataMap( _streamer_staging_data, false );
+
+        _custom_plots_graph.update( _custom_plots, _mapped_plot_data );
     }
 
     bool is_streaming_active = isStreamingActive();
@@ -1988,6 +2039,8 @@ void MainWindow::on_actionStopStreaming_triggered()
     _replot_timer->stop();
     _current_streamer->shutdown();
     _current_streamer = nullptr;
+    _streamer_staging_data.numeric.clear();
+    _streamer_staging_data.user_defined.clear();
 
     for(auto& action: ui->menuStreaming->actions()) {
         action->setEnabled(true);
@@ -2199,9 +2252,13 @@ void MainWindow::onRefreshMathPlot(const std::string &plot_name)
             qWarning("failed to find custom equation");
             return;
         }
-        CustomPlotPtr ce = custom_it->second;
-
-        ce->calculateAndAdd(_mapped_plot_data);
+        // calculate it again from scratch; the plots that read it will follow
+        auto data_it = _mapped_plot_data.numeric.find( plot_name );
+        if( data_it != _mapped_plot_data.numeric.end() )
+        {
+            data_it->second.clear();
+        }
+        _custom_plots_graph.update( _custom_plots, _mapped_plot_data );
 
         onUpdateLeftTableValues();
         updateDataAndReplot( true );
@@ -2278,6 +2335,16 @@ void MainWindow::addOrEditMathPlot(const std::string &name, bool modifying)
 
         if(modifying)
         {
+            try {
+                // the plots that read this one must be calculated again
+                _custom_plots_graph.update( _custom_plots, _mapped_plot_data );
+            }
+            catch(std::exception& ex)
+            {
+                QMessageBox::warning(this, tr("Warning"),
+                                     tr("Failed to update the custom timeseries. Error:\n\n%1")
+                                         .arg( ex.what() ) );
+            }
             updateDataAndReplot( true );
         }
     }
@@ -2323,6 +2390,47 @@ void MainWindow::publishPeriodically()
     } );
 }
 
+void MainWindow::compressUnusedData()
+{
+    // the series that are displayed are accessed at every replot
+    std::set<std::string> displayed_curves;
+    forEachWidget( [&](PlotWidget* plot)
+    {
+        for(const auto& it: plot->curveList())
+        {
+            displayed_curves.insert( it.first );
+        }
+    } );
+    // the sources of the custom plots are read at every update too
+    for(const auto& it: _custom_plots)
+    {
+        displayed_curves.insert( it.second->linkedPlotName() );
+        for(const auto& channel: it.second->usedChannels())
+        {
+            displayed_curves.insert( channel );
+        }
+    }
+
+    size_t total_saved = 0;
+    for(auto& it: _mapped_plot_data.numeric)
+    {
+        if( displayed_curves.count( it.first ) == 0 )
+        {
+            it.second.compress();
+        }
+        total_saved += it.second.compressionSavings();
+    }
+
+    if( total_saved > 0 )
+    {
+        statusBar()->showMessage( tr("Memory saved by compressing the unused data: %1 MB")
+                                  .arg( double(total_saved) / (1024*1024), 0, 'f', 1 ) );
+    }
+    else{
+        statusBar()->clearMessage();
+    }
+}
+
 void MainWindow::on_actionReportBug_triggered()
 {
     QDesktopServices::openUrl( QUrl( "https://github.com/facontidavide/PlotJuggler/issues" ));
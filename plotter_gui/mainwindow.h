@@ -20,6 +20,7 @@
 #include "PlotJuggler/statepublisher_base.h"
 #include "PlotJuggler/datastreamer_base.h"
 #include "transforms/custom_function.h"
+#include "transforms/custom_plot_graph.h"
 
 namespace Ui {
 class MainWindow;
@@ -137,6 +138,8 @@ private slots:
 
     void publishPeriodically();
 
+    void compressUnusedData();
+
     void on_actionReportBug_triggered();
 
     void on_actionCheatsheet_triggered();
@@ -170,8 +173,13 @@ private:
 
     PlotDataMapRef  _mapped_plot_data;
 
+    // data taken from the streamer, waiting to be imported into _mapped_plot_data
+    PlotDataMapRef  _streamer_staging_data;
+
     CustomPlotMap _custom_plots;
 
+    CustomPlotGraph _custom_plots_graph;
+
     void rearrangeGridLayout();
 
     void loadPlugins(QString subdir_name);
@@ -203,6 +211,9 @@ private:
 
     double _tracker_time;
 
+    // the tracker moves by small steps: remember where each series was last looked up
+    std::unordered_map<std::string, PlotData::Cursor> _tracker_cursors;
+
     QString _loaded_datafile;
 
     QSignalMapper *_streamer_signal_mapper;
@@ -237,6 +248,8 @@ protected:
 
     QTimer *_publish_timer;
 
+    QTimer *_compress_timer;
+
     QDateTime _prev_publish_time;
 
 signals:
@@ -379,7 +379,7 @@ bool PlotWidget::addCurve(const std::string &name)
     PlotData& data = it->second;
     const auto qname = QString::fromStdString( name );
 
-    auto curve = new QwtPlotCurve( qname );
+    auto curve = new DecimatedCurve( qname );
     try {
         auto plot_qwt = createSeriesData( _default_transform, &data );
         _curves_transform.insert( {name, _default_transform} );
@@ -20,6 +20,7 @@
 #include "qwt_plot_legenditem.h"
 #include "timeseries_qwt.h"
 #include "customtracker.h"
+#include "decimated_curve.h"
 #include "axis_limits_dialog.h"
 #include "transforms/transform_selector.h"
 #include "transforms/custom_function.h"
@@ -1,6 +1,8 @@
 #include "point_series_xy.h"
 #include <cmath>
 #include <cstdlib>
+#include <algorithm>
+#include "PlotJuggler/time_join.h"
 
 PointSeriesXY::PointSeriesXY(const PlotData *y_axis, const PlotData *x_axis):
     DataSeriesBase( &_cached_curve ),
@@ -28,12 +30,14 @@ nonstd::optional<QPointF> PointSeriesXY::sampleFromTime(double t)
         return {};
     }
 
-    int index = _y_axis->getIndexFromX(t);
-    if(index <0)
+    // nearest sample in time
+    size_t index = std::lower_bound( _cached_times.begin(), _cached_times.end(), t ) - _cached_times.begin();
+    if( index == _cached_times.size() ||
+        ( index > 0 && t - _cached_times[index-1] < _cached_times[index] - t ) )
     {
-        return {};
+        index--;
     }
-    const auto& p = _cached_curve.at( size_t(index) );
+    const auto& p = _cached_curve.at( index );
     return QPointF(p.x, p.y);
 }
 
@@ -51,15 +55,22 @@ bool PointSeriesXY::updateCache()
         throw std::runtime_error("the X axis is null");
     }
 
-    const size_t data_size =  _x_axis->size();
+    // X and Y might have different timestamps: interpolate them on the union of both
+    TimeAlignedJoin join( { _x_axis, _y_axis }, TimeAlignedJoin::LINEAR );
 
-    if( data_size != _x_axis->size() )
+    std::vector<double> xs, ys;
+    xs.reserve( _x_axis->size() + _y_axis->size() );
+    ys.reserve( _x_axis->size() + _y_axis->size() );
+    _cached_times.clear();
+    while( join.next() )
     {
-        _bounding_box = QRectF();
-        _cached_curve.clear();
-        throw std::runtime_error("X and Y axis don't share the same time axis");
+        _cached_times.push_back( join.time() );
+        xs.push_back( join.values()[0] );
+        ys.push_back( join.values()[1] );
     }
 
+    const size_t data_size = _cached_times.size();
+
     if(data_size == 0)
     {
         _bounding_box = QRectF();
@@ -74,19 +85,9 @@ bool PointSeriesXY::updateCache()
 
     _cached_curve.resize( data_size );
 
-    const double EPS = std::numeric_limits<double>::epsilon();
-
     for (size_t i=0; i<data_size; i++ )
     {
-        if( Abs( _x_axis->at(i).x  - _y_axis->at(i).x ) >  EPS)
-        {
-            _bounding_box = QRectF();
-            _cached_curve.clear();
-            throw std::runtime_error("X and Y axis don't share the same time axis");
-        }
-
-        const QPointF p(_x_axis->at(i).y,
-                        _y_axis->at(i).y );
+        const QPointF p( xs[i], ys[i] );
 
         _cached_curve.at(i) = { p.x(), p.y() };
 
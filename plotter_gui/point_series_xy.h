@@ -1,6 +1,7 @@
 #ifndef POINT_SERIES_H
 #define POINT_SERIES_H
 
+#include <vector>
 #include "series_data.h"
 
 class PointSeriesXY: public DataSeriesBase
@@ -32,6 +33,8 @@ protected:
     const PlotData *_x_axis;
     const PlotData *_y_axis;
     PlotData _cached_curve;
+    // time of each sample of _cached_curve
+    std::vector<double> _cached_times;
 };
 
 #endif // POINT_SERIES_H
@@ -37,6 +37,8 @@ public:
         _time_offset = offset;
     }
 
+    double timeOffset() const { return _time_offset; }
+
 
     void calculateBoundingBox();
 
@@ -48,7 +50,7 @@ public:
 
     virtual PlotData::RangeTimeOpt getVisualizationRangeX()
     {
-        if( this->size() < 2 )
+        if( _transformed_data->size() < 2 )
             return  PlotData::RangeTimeOpt();
         else{
             return PlotData::RangeTimeOpt( { _bounding_box.left()  - _time_offset,
@@ -75,25 +77,12 @@ inline void DataSeriesBase::calculateBoundingBox()
         return;
     }
 
-    double min_y = _transformed_data->front().y;
-    double max_y = _transformed_data->front().y;
-
-    for (const auto& p: *_transformed_data )
-    {
-        if( p.y < min_y )
-        {
-            min_y = p.y;
-        }
-        else if( p.y > max_y )
-        {
-           max_y = p.y;
-        }
-    }
+    const auto stats = _transformed_data->statistics();
 
     _bounding_box.setLeft(  _transformed_data->front().x );
     _bounding_box.setRight( _transformed_data->back().x );
-    _bounding_box.setBottom( min_y );
-    _bounding_box.setTop( max_y );
+    _bounding_box.setBottom( stats.min );
+    _bounding_box.setTop( stats.max );
 }
 
 #endif // SERIES_DATA_H
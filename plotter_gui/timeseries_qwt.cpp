@@ -1,15 +1,158 @@
 #include "timeseries_qwt.h"
 #include <limits>
+#include <vector>
 #include <stdexcept>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QString>
 
-TimeseriesQwt::TimeseriesQwt(const PlotData *source_data, const PlotData *transformed_data):
-    DataSeriesBase( transformed_data ),
+namespace {
+
+// Copy the samples [first, size) of data into contiguous columns
+void copyColumns(const PlotData& data, size_t first,
+                 std::vector<double>& times, std::vector<double>& values)
+{
+    times.clear();
+    values.clear();
+    times.reserve( data.size() - first );
+    values.reserve( data.size() - first );
+    for(const auto& span: data.spans( first, data.size() ))
+    {
+        if( span.times() )
+        {
+            times.insert( times.end(), span.times(), span.times() + span.size() );
+        }
+        else{
+            for(size_t i=0; i < span.size(); i++) {
+                times.push_back( span.time(i) );
+            }
+        }
+        values.insert( values.end(), span.values(), span.values() + span.size() );
+    }
+}
+
+// The derivatives are computed on contiguous columns with branchless loops,
+// that the compiler can vectorize. "count" is the number of output samples.
+
+void firstDerivative(const double* t, const double* y, size_t count,
+                     double* out_t, double* out_y)
+{
+    for (size_t i=0; i < count; i++ )
+    {
+        out_t[i] = (t[i+1] + t[i]) * 0.5;
+        out_y[i] = (y[i+1] - y[i]) / (t[i+1] - t[i]);
+    }
+}
+
+void secondDerivative(const double* t, const double* y, size_t count,
+                      double* out_t, double* out_y)
+{
+    for (size_t i=0; i < count; i++ )
+    {
+        const double delta = (t[i+2] - t[i]) * 0.5;
+        out_t[i] = (t[i+2] + t[i]) * 0.5;
+        out_y[i] = (y[i+2] - 2.0 * y[i+1] + y[i]) / (delta * delta);
+    }
+}
+
+}
+
+std::map<TransformCache::Key, std::weak_ptr<TransformedData>> TransformCache::_entries;
+
+std::shared_ptr<TransformedData> TransformCache::get(const PlotData *source,
+                                                     const std::string &transform_key,
+                                                     const Factory& create)
+{
+    // forget the entries that are not used anymore
+    for(auto it = _entries.begin(); it != _entries.end(); )
+    {
+        if( it->second.expired() ) {
+            it = _entries.erase(it);
+        }
+        else{
+            it++;
+        }
+    }
+
+    std::weak_ptr<TransformedData>& entry = _entries[ Key(source, transform_key) ];
+    std::shared_ptr<TransformedData> transformed = entry.lock();
+    if( !transformed )
+    {
+        transformed = create ? create() : std::make_shared<TransformedData>();
+        entry = transformed;
+    }
+    return transformed;
+}
+
+TimeseriesQwt::TimeseriesQwt(const PlotData *source_data,
+                             std::shared_ptr<TransformedData> transformed):
+    DataSeriesBase( transformed ? &transformed->data : source_data ),
     _source_data(source_data),
-    _cached_data("")
+    _transformed(transformed)
 {
+    _visible_cache.data_size = 0;
+}
+
+size_t TimeseriesQwt::prepareIncrementalUpdate()
+{
+    const size_t evicted = _source_data->evictedCount();
+    const size_t source_end = evicted + _source_data->size();
+    size_t first = 0;
+
+    TransformedData& transformed = *_transformed;
+
+    if( transformed.source_generation == _source_data->generation() &&
+        transformed.processed_end <= source_end )
+    {
+        first = ( transformed.processed_end > evicted ) ? transformed.processed_end - evicted : 0;
+    }
+    else{
+        transformed.data.clear();
+        transformed.source_generation = _source_data->generation();
+    }
+    transformed.processed_end = source_end;
+    return first;
+}
+
+std::pair<size_t,size_t> TimeseriesQwt::visibleRange() const
+{
+    const PlotData* data = transformedData();
+    const size_t data_size = data->size();
+
+    if( data_size == 0 || _rect_of_interest.width() <= 0 )
+    {
+        return { 0, data_size };
+    }
+
+    auto& cache = _visible_cache;
+    if( cache.data_size  == data_size &&
+        cache.front_time == data->front().x &&
+        cache.back_time  == data->back().x &&
+        cache.time_offset == timeOffset() &&
+        cache.rect == _rect_of_interest )
+    {
+        return cache.range;
+    }
+
+    const double t_min = _rect_of_interest.left()  + timeOffset();
+    const double t_max = _rect_of_interest.right() + timeOffset();
+
+    size_t first = data->lowerBound( t_min );
+    size_t last  = data->upperBound( t_max );
+    // one sample of margin on each side
+    if( first > 0 )
+    {
+        first--;
+    }
+    last = std::min( last + 1, data_size );
+
+    cache.rect = _rect_of_interest;
+    cache.time_offset = timeOffset();
+    cache.data_size = data_size;
+    cache.front_time = data->front().x;
+    cache.back_time = data->back().x;
+    cache.range = { first, last };
+    return cache.range;
 }
 
 PlotData::RangeValueOpt TimeseriesQwt::getVisualizationRangeY(PlotData::RangeTime range_X)
@@ -29,16 +172,7 @@ PlotData::RangeValueOpt TimeseriesQwt::getVisualizationRangeY(PlotData::RangeTim
                                           _bounding_box.top() } );
     }
 
-    double min_y =( std::numeric_limits<double>::max() );
-    double max_y =(-std::numeric_limits<double>::max() );
-
-    for (size_t i = first_index; i < last_index; i++)
-    {
-        const double Y = sample(i).y();
-        min_y = std::min( min_y, Y );
-        max_y = std::max( max_y, Y );
-    }
-    return PlotData::RangeValueOpt( { min_y, max_y } );
+    return transformedData()->rangeY( first_index, last_index + 1 );
 }
 
 
@@ -62,26 +196,31 @@ bool Timeseries_NoTransform::updateCache()
 
 bool Timeseries_1stDerivative::updateCache()
 {
-    size_t data_size = _source_data->size();
+    const size_t first = std::max<size_t>( prepareIncrementalUpdate(), 1 );
+    const size_t data_size = _source_data->size();
+
+    PlotData& derivative = _transformed->data;
 
     if( data_size <= 1)
     {
-        _cached_data.clear();
+        derivative.clear();
         _bounding_box = QRectF();
         return true;
     }
 
-    data_size = data_size - 1;
-    _cached_data.resize( data_size );
+    // drop the derivatives of the samples evicted from the source
+    const double first_time = (_source_data->timeAt(0) + _source_data->timeAt(1)) * 0.5;
+    derivative.popFront( derivative.lowerBound( first_time ) );
 
-    for (size_t i=0; i < data_size; i++ )
+    // nothing to do if another curve already updated the shared data
+    if( first < data_size )
     {
-        const auto& p0 = _source_data->at( i );
-        const auto& p1 = _source_data->at( i+1 );
-        const auto delta = p1.x - p0.x;
-        const auto vel = (p1.y - p0.y) /delta;
-        QPointF p( (p1.x + p0.x)*0.5, vel);
-        _cached_data[i] = { p.x(), p.y() };
+        std::vector<double> times, values;
+        copyColumns( *_source_data, first - 1, times, values );
+        const size_t count = times.size() - 1;
+        std::vector<double> out_times( count ), out_values( count );
+        firstDerivative( times.data(), values.data(), count, out_times.data(), out_values.data() );
+        derivative.pushBackBatch( out_times.data(), out_values.data(), count );
     }
 
     calculateBoundingBox();
@@ -90,27 +229,31 @@ bool Timeseries_1stDerivative::updateCache()
 
 bool Timeseries_2ndDerivative::updateCache()
 {
-    size_t data_size = _source_data->size();
+    const size_t first = std::max<size_t>( prepareIncrementalUpdate(), 2 );
+    const size_t data_size = _source_data->size();
+
+    PlotData& derivative = _transformed->data;
 
     if( data_size <= 2)
     {
-        _cached_data.clear();
+        derivative.clear();
         _bounding_box = QRectF();
         return true;
     }
 
-    data_size = data_size - 2;
-    _cached_data.resize( data_size );
+    // drop the derivatives of the samples evicted from the source
+    const double first_time = (_source_data->timeAt(0) + _source_data->timeAt(2)) * 0.5;
+    derivative.popFront( derivative.lowerBound( first_time ) );
 
-    for (size_t i=0; i < data_size; i++ )
+    // nothing to do if another curve already updated the shared data
+    if( first < data_size )
     {
-        const auto& p0 = _source_data->at( i );
-        const auto& p1 = _source_data->at( i+1 );
-        const auto& p2 = _source_data->at( i+2 );
-        const auto delta = (p2.x - p0.x) *0.5;
-        const auto acc = ( p2.y - 2.0* p1.y + p0.y)/(delta*delta);
-        QPointF p( (p2.x + p0.x)*0.5, acc );
-        _cached_data[i] = { p.x(), p.y() };
+        std::vector<double> times, values;
+        copyColumns( *_source_data, first - 2, times, values );
+        const size_t count = times.size() - 2;
+        std::vector<double> out_times( count ), out_values( count );
+        secondDerivative( times.data(), values.data(), count, out_times.data(), out_values.data() );
+        derivative.pushBackBatch( out_times.data(), out_values.data(), count );
     }
 
     calculateBoundingBox();
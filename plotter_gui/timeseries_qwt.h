@@ -1,14 +1,63 @@
 #ifndef PLOTDATA_QWT_H
 #define PLOTDATA_QWT_H
 
+#include <map>
+#include <memory>
+#include <functional>
 #include "series_data.h"
 #include "PlotJuggler/plotdata.h"
 
+// Transformed samples of a series, with the state needed to update them incrementally.
+struct TransformedData
+{
+    TransformedData(): data(""), source_generation(0), processed_end(0) {}
+    virtual ~TransformedData() {}
+
+    PlotData data;
+    size_t source_generation;
+    size_t processed_end; // evictedCount() + size() of the source, at the last update
+};
+
+// The curves that display the same series with the same transform, in any PlotWidget,
+// share the same TransformedData: it is computed only once per update.
+class TransformCache
+{
+public:
+    typedef std::function<std::shared_ptr<TransformedData>()> Factory;
+
+    // The entry is released when the last curve that uses it is destroyed.
+    static std::shared_ptr<TransformedData> get(const PlotData* source,
+                                                const std::string& transform_key,
+                                                const Factory& create = Factory());
+private:
+    typedef std::pair<const PlotData*, std::string> Key;
+    static std::map<Key, std::weak_ptr<TransformedData>> _entries;
+};
+
 class TimeseriesQwt: public DataSeriesBase
 {
 public:
 
-    TimeseriesQwt(const PlotData *source_data, const PlotData* transformed_data);
+    // if transformed is empty, source_data is displayed as it is
+    TimeseriesQwt(const PlotData *source_data, std::shared_ptr<TransformedData> transformed);
+
+    // Only the samples inside the rect of interest (plus one on each side) are exposed to Qwt
+    virtual QPointF sample( size_t i ) const override
+    {
+        return DataSeriesBase::sample( visibleRange().first + i );
+    }
+
+    virtual size_t size() const override
+    {
+        const auto range = visibleRange();
+        return range.second - range.first;
+    }
+
+    // Invoked by Qwt with the current scales of the axes, i.e. after zoom and pan.
+    virtual void setRectOfInterest( const QRectF& rect ) override
+    {
+        _rect_of_interest = rect;
+    }
 
     PlotData::RangeValueOpt getVisualizationRangeY(PlotData::RangeTime range_X) override;
 
@@ -16,7 +65,30 @@ public:
 
 protected:
     const PlotData*  _source_data;
-    PlotData   _cached_data;
+    std::shared_ptr<TransformedData> _transformed;
+
+    // Index of the first sample of _source_data that was not processed yet.
+    // When the source was modified in a way other than appending or evicting samples,
+    // the transformed data is cleared and 0 is returned.
+    size_t prepareIncrementalUpdate();
+
+private:
+
+    // indexes [first, last) of the visible samples in transformedData()
+    std::pair<size_t,size_t> visibleRange() const;
+
+    QRectF _rect_of_interest;
+
+    // visibleRange() is recalculated only when the data, the offset or the rect change
+    struct VisibleRangeCache{
+        QRectF rect;
+        double time_offset;
+        size_t data_size;
+        double front_time;
+        double back_time;
+        std::pair<size_t,size_t> range;
+    };
+    mutable VisibleRangeCache _visible_cache;
 };
 
 //---------------------------------------------------------
@@ -25,7 +97,7 @@ class Timeseries_NoTransform: public TimeseriesQwt
 {
 public:
     Timeseries_NoTransform(const PlotData* source_data):
-        TimeseriesQwt( source_data, source_data )
+        TimeseriesQwt( source_data, nullptr )
     {
         updateCache();
     }
@@ -38,7 +110,7 @@ class Timeseries_1stDerivative: public TimeseriesQwt
 {
 public:
     Timeseries_1stDerivative(const PlotData* source_data):
-        TimeseriesQwt(source_data, &_cached_data)
+        TimeseriesQwt(source_data, TransformCache::get(source_data, "1st Derivative") )
     {
         updateCache();
     }
@@ -50,7 +122,7 @@ class Timeseries_2ndDerivative: public TimeseriesQwt
 {
 public:
     Timeseries_2ndDerivative(const PlotData* source_data):
-        TimeseriesQwt(source_data, &_cached_data)
+        TimeseriesQwt(source_data, TransformCache::get(source_data, "2nd Derivative") )
     {
         updateCache();
     }
@@ -1,10 +1,88 @@
 #include "custom_function.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
 #include <limits>
+#include <mutex>
+#include <thread>
 #include <QFile>
 #include <QMessageBox>
 #include <QElapsedTimer>
 
+class CustomFunction::ScriptThread
+{
+public:
+    ScriptThread(): _pending(false), _stop(false)
+    {
+        _thread = std::thread( [this](){ loop(); } );
+    }
+
+    ~ScriptThread()
+    {
+        {
+            std::lock_guard<std::mutex> lock( _mutex );
+            _stop = true;
+        }
+        _condition.notify_all();
+        _thread.join();
+    }
+
+    // Execute the task in this thread and wait for it. Exceptions are rethrown to the caller.
+    void run(const std::function<void()>& task)
+    {
+        std::lock_guard<std::mutex> caller_lock( _caller_mutex );
+        std::unique_lock<std::mutex> lock( _mutex );
+        _task = task;
+        _error = nullptr;
+        _pending = true;
+        _condition.notify_all();
+        _condition.wait( lock, [this](){ return !_pending; } );
+        _task = nullptr;
+        if( _error )
+        {
+            std::rethrow_exception( _error );
+        }
+    }
+
+private:
+    void loop()
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        while( true )
+        {
+            _condition.wait( lock, [this](){ return _pending || _stop; } );
+            if( !_pending )
+            {
+                return;
+            }
+            lock.unlock();
+            std::exception_ptr error;
+            try{
+                _task();
+            }
+            catch(...)
+            {
+                error = std::current_exception();
+            }
+            lock.lock();
+            _error = error;
+            _pending = false;
+            _condition.notify_all();
+        }
+    }
+
+    std::mutex _caller_mutex;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::function<void()> _task;
+    std::exception_ptr _error;
+    bool _pending;
+    bool _stop;
+    std::thread _thread;
+};
+
 CustomFunction::CustomFunction(const std::string &linkedPlot,
                                const SnippetData &snippet):
     CustomFunction(linkedPlot,
@@ -43,8 +121,7 @@ CustomFunction::CustomFunction(const std::string &linkedPlot,
     _linked_plot_name(linkedPlot),
     _plot_name(plotName),
     _global_vars(globalVars),
-    _function(function),
-    _last_updated_timestamp( - std::numeric_limits<double>::max() )
+    _function(function)
 {
 
     QString qLinkedPlot = QString::fromStdString(_linked_plot_name);
@@ -80,7 +157,33 @@ CustomFunction::CustomFunction(const std::string &linkedPlot,
     _function_replaced = replaced_equation;
 
     //qDebug() << "final equation string : " << replaced_equation;
-    initJsEngine();
+    _native = NativeExpression::compile( _global_vars.toStdString(),
+                                         _function_replaced.toStdString(),
+                                         _used_channels.size() );
+    if( !_native )
+    {
+        _js_thread.reset( new ScriptThread );
+        _js_thread->run( [this]()
+        {
+            try{
+                initJsEngine();
+            }
+            catch(...)
+            {
+                // the engine must be destroyed in the thread that created it
+                _jsEngine.reset();
+                throw;
+            }
+        } );
+    }
+}
+
+CustomFunction::~CustomFunction()
+{
+    if( _js_thread )
+    {
+        _js_thread->run( [this](){ _jsEngine.reset(); } );
+    }
 }
 
 void CustomFunction::calculateAndAdd(PlotDataMapRef &plotData)
@@ -121,52 +224,73 @@ void CustomFunction::initJsEngine()
     }
     QString calcMethodStr = QString("function calc(time, value, CHANNEL_VALUES){with (Math){\n%1\n}}").arg(_function_replaced);
     _jsEngine->evaluate(calcMethodStr);
+
+    // calc() is called for an entire batch of samples from JS itself: the columns are
+    // passed as ArrayBuffers and the results returned the same way, therefore the
+    // boundary between C++ and JS is crossed once per batch and not once per sample.
+    _jsEngine->evaluate(
+        "function calcBatch(time_buffer, value_buffer, channel_buffers){\n"
+        "  var times = new Float64Array(time_buffer);\n"
+        "  var values = new Float64Array(value_buffer);\n"
+        "  var channels = [];\n"
+        "  for(var c=0; c < channel_buffers.length; c++){\n"
+        "    channels.push( new Float64Array(channel_buffers[c]) );\n"
+        "  }\n"
+        "  var chan_values = new Array(channels.length);\n"
+        "  var result = new Float64Array(times.length);\n"
+        "  for(var i=0; i < times.length; i++){\n"
+        "    for(var c=0; c < channels.length; c++){\n"
+        "      chan_values[c] = channels[c][i];\n"
+        "    }\n"
+        "    result[i] = calc(times[i], values[i], chan_values);\n"
+        "  }\n"
+        "  return result.buffer;\n"
+        "}\n" );
 }
 
-PlotData::Point CustomFunction::calculatePoint(QJSValue& calcFct,
-                                const PlotData& src_data,
-                                const std::vector<const PlotData*>& channels_data,
-                                QJSValue& chan_values,
-                                size_t point_index)
+void CustomFunction::calculateBatch(const std::vector<double>& times,
+                                    const std::vector<double>& values,
+                                    const std::vector<const double*>& channels_columns,
+                                    double* results)
 {
-    const PlotData::Point &old_point = src_data.at(point_index);
+    const int bytes = static_cast<int>( times.size() * sizeof(double) );
 
-    int chan_index = 0;
-    for(const PlotData* chan_data: channels_data)
+    _js_thread->run( [&]()
     {
-        double value;
-        int index = chan_data->getIndexFromX(old_point.x);
-        if(index != -1){
-            value = chan_data->at(index).y;
-        }
-        else{
-            value = std::numeric_limits<double>::quiet_NaN();
+        QJSValue calcBatchFct = _jsEngine->evaluate("calcBatch");
+        if(calcBatchFct.isError())
+        {
+            throw std::runtime_error("JS Engine : " + calcBatchFct.toString().toStdString());
         }
-        chan_values.setProperty(static_cast<quint32>(chan_index++), QJSValue(value));
-    }
 
-    PlotData::Point new_point;
-    new_point.x = old_point.x;
+        QJSValue channel_buffers = _jsEngine->newArray(static_cast<quint32>(channels_columns.size()));
+        for(size_t c=0; c < channels_columns.size(); c++)
+        {
+            QByteArray column( reinterpret_cast<const char*>(channels_columns[c]), bytes );
+            channel_buffers.setProperty( static_cast<quint32>(c), _jsEngine->toScriptValue(column) );
+        }
 
-    QJSValue jsData = calcFct.call({QJSValue(old_point.x), QJSValue(old_point.y), chan_values});
-    if(jsData.isError())
-    {
-        throw std::runtime_error("JS Engine : " + jsData.toString().toStdString());
-    }
-    new_point.y = jsData.toNumber();
+        QByteArray time_buffer( reinterpret_cast<const char*>(times.data()), bytes );
+        QByteArray value_buffer( reinterpret_cast<const char*>(values.data()), bytes );
 
-    return new_point;
+        QJSValue jsData = calcBatchFct.call({ _jsEngine->toScriptValue(time_buffer),
+                                              _jsEngine->toScriptValue(value_buffer),
+                                              channel_buffers });
+        if(jsData.isError())
+        {
+            throw std::runtime_error("JS Engine : " + jsData.toString().toStdString());
+        }
+        const QByteArray result_buffer = jsData.toVariant().toByteArray();
+        if( result_buffer.size() != bytes )
+        {
+            throw std::runtime_error("JS Engine : unexpected size of the result");
+        }
+        std::memcpy( results, result_buffer.constData(), times.size() * sizeof(double) );
+    } );
 }
 
 void CustomFunction::calculate(const PlotDataMapRef &plotData, PlotData* dst_data)
 {
-    QJSValue calcFct = _jsEngine->evaluate("calc");
-
-    if(calcFct.isError())
-    {
-        throw std::runtime_error("JS Engine : " + calcFct.toString().toStdString());
-    }
-
     auto src_data_it = plotData.numeric.find(_linked_plot_name);
     if(src_data_it == plotData.numeric.end())
     {
@@ -192,16 +316,65 @@ void CustomFunction::calculate(const PlotDataMapRef &plotData, PlotData* dst_dat
         channel_data.push_back(chan_data);
     }
 
-    QJSValue chan_values = _jsEngine->newArray(static_cast<quint32>(_used_channels.size()));
+    // only the points newer than the ones already in dst_data are calculated
+    const size_t first = ( dst_data->size() > 0 ) ? src_data.upperBound( dst_data->back().x ) : 0;
 
-    for(size_t i=0; i < src_data.size(); ++i)
+    // large enough to make the cost of each call negligible,
+    // small enough to bound the memory used by the columns
+    const size_t BATCH_SIZE = 64*1024;
+
+    std::vector<double> times;
+    std::vector<double> values;
+    std::vector<double> results;
+    std::vector<std::vector<double>> channels_values( channel_data.size() );
+    std::vector<const double*> channels_columns( channel_data.size() );
+    std::vector<PlotData::Cursor> channels_cursor( channel_data.size() );
+
+    for(size_t batch_first = first; batch_first < src_data.size(); batch_first += BATCH_SIZE)
     {
-        if( src_data.at(i).x > _last_updated_timestamp)
+        const size_t batch_last = std::min( batch_first + BATCH_SIZE, src_data.size() );
+        const size_t count = batch_last - batch_first;
+
+        times.clear();
+        values.clear();
+        for(const auto& span: src_data.spans( batch_first, batch_last ))
+        {
+            if( span.times() )
+            {
+                times.insert( times.end(), span.times(), span.times() + span.size() );
+            }
+            else{
+                for(size_t i=0; i < span.size(); i++) {
+                    times.push_back( span.time(i) );
+                }
+            }
+            values.insert( values.end(), span.values(), span.values() + span.size() );
+        }
+
+        for(size_t c=0; c < channel_data.size(); c++)
+        {
+            std::vector<double>& column = channels_values[c];
+            column.resize( count );
+            for(size_t i=0; i < count; i++)
+            {
+                // the points are processed in order: the cursor makes the lookup O(1)
+                int index = channel_data[c]->getIndexFromX( times[i], channels_cursor[c] );
+                column[i] = ( index != -1 ) ? channel_data[c]->at(index).y :
+                                              std::numeric_limits<double>::quiet_NaN();
+            }
+            channels_columns[c] = column.data();
+        }
+
+        results.resize( count );
+        if( _native )
         {
-            dst_data->pushBack( calculatePoint(calcFct, src_data, channel_data, chan_values, i ) );
+            _native->evaluate( times.data(), values.data(), channels_columns, count, results.data() );
+        }
+        else{
+            calculateBatch( times, values, channels_columns, results.data() );
         }
+        dst_data->pushBackBatch( times.data(), results.data(), count );
     }
-    _last_updated_timestamp = dst_data->back().x;
 }
 
 const std::string &CustomFunction::name() const
@@ -214,6 +387,11 @@ const std::string &CustomFunction::linkedPlotName() const
     return _linked_plot_name;
 }
 
+const std::vector<std::string> &CustomFunction::usedChannels() const
+{
+    return _used_channels;
+}
+
 const QString &CustomFunction::globalVars() const
 {
     return _global_vars;
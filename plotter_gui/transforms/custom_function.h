@@ -8,6 +8,7 @@
 #include <QString>
 #include <QJSEngine>
 #include "PlotJuggler/plotdata.h"
+#include "native_expression.h"
 
 class CustomFunction;
 class QJSEngine;
@@ -40,14 +41,20 @@ public:
     CustomFunction(const std::string &linkedPlot,
                    const SnippetData &snippet);
 
+    ~CustomFunction();
+
     void calculateAndAdd(PlotDataMapRef &plotData);
 
+    // Can be called from any thread, provided that the data is not modified meanwhile.
     void calculate(const PlotDataMapRef &plotData, PlotData *dst_data);
 
     const std::string& name() const;
 
     const std::string& linkedPlotName() const;
 
+    // the series used with the $$name$$ syntax, besides the linked one
+    const std::vector<std::string>& usedChannels() const;
+
     const QString& globalVars() const;
 
     const QString& function() const;
@@ -61,11 +68,10 @@ public:
 private:
     void initJsEngine();
 
-    PlotData::Point  calculatePoint(QJSValue &calcFct,
-                                    const PlotData &src_data,
-                                    const std::vector<const PlotData *> &channels_data,
-                                    QJSValue &chan_values,
-                                    size_t point_index);
+    void calculateBatch(const std::vector<double> &times,
+                        const std::vector<double> &values,
+                        const std::vector<const double *> &channels_columns,
+                        double *results);
 
     const std::string _linked_plot_name;
     const std::string _plot_name;
@@ -74,8 +80,13 @@ private:
     QString _function_replaced;
     std::vector<std::string> _used_channels;
 
+    // QJSEngine must be used only by the thread that created it. _jsEngine lives in
+    // _js_thread and all the calls to it are executed there, whatever the calling thread.
+    class ScriptThread;
+    std::unique_ptr<ScriptThread> _js_thread;
     std::unique_ptr<QJSEngine> _jsEngine;
-    double _last_updated_timestamp;
+    // nullptr if the snippet must be executed by _jsEngine
+    std::unique_ptr<NativeExpression> _native;
 };
 
 
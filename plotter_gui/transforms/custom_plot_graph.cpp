@@ -0,0 +1,207 @@
+#include "custom_plot_graph.h"
+
+#include <exception>
+#include <set>
+#include <QtConcurrentMap>
+
+bool CustomPlotGraph::hasChanged(const CustomPlotMap& custom_plots) const
+{
+    if( custom_plots.size() != _nodes.size() )
+    {
+        return true;
+    }
+    for(const auto& it: custom_plots)
+    {
+        auto node_it = _nodes.find( it.first );
+        if( node_it == _nodes.end() || node_it->second.function != it.second )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CustomPlotGraph::rebuild(const CustomPlotMap& custom_plots)
+{
+    std::map<std::string, Node> nodes;
+    for(const auto& it: custom_plots)
+    {
+        auto old_it = _nodes.find( it.first );
+        if( old_it != _nodes.end() && old_it->second.function == it.second )
+        {
+            // same function: keep the state of its inputs
+            nodes[it.first] = old_it->second;
+            continue;
+        }
+        Node& node = nodes[it.first];
+        node.function = it.second;
+        node.inputs.push_back( it.second->linkedPlotName() );
+        for(const auto& channel: it.second->usedChannels())
+        {
+            node.inputs.push_back( channel );
+        }
+    }
+    _nodes.swap( nodes );
+
+    // Kahn's algorithm, one level at a time
+    std::set<std::string> pending;
+    for(const auto& it: _nodes)
+    {
+        pending.insert( it.first );
+    }
+    _levels.clear();
+    while( !pending.empty() )
+    {
+        std::vector<std::string> level;
+        for(const auto& name: pending)
+        {
+            bool ready = true;
+            for(const auto& input: _nodes[name].inputs)
+            {
+                ready = ready && pending.count( input ) == 0;
+            }
+            if( ready )
+            {
+                level.push_back( name );
+            }
+        }
+        if( level.empty() )
+        {
+            break;
+        }
+        for(const auto& name: level)
+        {
+            pending.erase( name );
+        }
+        _levels.push_back( std::move(level) );
+    }
+    // what is left is part of a cycle, or depends on one
+    for(const auto& name: pending)
+    {
+        _levels.push_back( {name} );
+    }
+}
+
+CustomPlotGraph::Signature CustomPlotGraph::signature(const PlotDataMapRef& plot_data,
+                                                      const std::string& name)
+{
+    Signature sig;
+    auto it = plot_data.numeric.find( name );
+    if( it != plot_data.numeric.end() )
+    {
+        sig.exists = true;
+        sig.generation = it->second.generation();
+        sig.total = it->second.evictedCount() + it->second.size();
+    }
+    return sig;
+}
+
+void CustomPlotGraph::update(const CustomPlotMap& custom_plots, PlotDataMapRef& plot_data)
+{
+    if( hasChanged( custom_plots ) )
+    {
+        rebuild( custom_plots );
+    }
+
+    struct Task{
+        Node* node;
+        PlotData* dst_plot;
+        std::exception_ptr error;
+    };
+
+    for(const auto& level: _levels)
+    {
+        std::vector<Task> tasks;
+        std::set<std::string> sources;
+
+        for(const auto& name: level)
+        {
+            Node& node = _nodes[name];
+
+            auto dst_it = plot_data.numeric.find( name );
+            if( dst_it == plot_data.numeric.end() )
+            {
+                dst_it = plot_data.addNumeric( name );
+            }
+            PlotData& dst_plot = dst_it->second;
+
+            bool changed = !node.calculated || node.output_state != signature( plot_data, name );
+            bool rewritten = false;
+            for(size_t i=0; i < node.inputs.size(); i++)
+            {
+                const Signature current = signature( plot_data, node.inputs[i] );
+                if( node.calculated && current != node.inputs_state[i] )
+                {
+                    changed = true;
+                    // old samples might be different: the new ones are not enough
+                    rewritten = rewritten || current.generation != node.inputs_state[i].generation;
+                }
+            }
+            if( !changed )
+            {
+                continue;
+            }
+            if( rewritten )
+            {
+                dst_plot.clear();
+            }
+            tasks.push_back( { &node, &dst_plot, nullptr } );
+            sources.insert( node.inputs.begin(), node.inputs.end() );
+        }
+
+        // compressed chunks are decompressed on demand also by the const methods of PlotData,
+        // that therefore are not thread safe. Do it here, before the sources are shared.
+        for(const auto& name: sources)
+        {
+            auto it = plot_data.numeric.find( name );
+            if( it != plot_data.numeric.end() )
+            {
+                it->second.decompress();
+            }
+        }
+
+        const PlotDataMapRef& const_data = plot_data;
+        auto calculate = [&const_data](Task& task)
+        {
+            try{
+                task.node->function->calculate( const_data, task.dst_plot );
+            }
+            catch(...)
+            {
+                task.error = std::current_exception();
+            }
+        };
+
+        if( tasks.size() == 1 )
+        {
+            calculate( tasks.front() );
+        }
+        else if( tasks.size() > 1 )
+        {
+            QtConcurrent::blockingMap( tasks, calculate );
+        }
+
+        std::exception_ptr error;
+        for(Task& task: tasks)
+        {
+            if( task.error )
+            {
+                error = error ? error : task.error;
+                continue;
+            }
+            Node& node = *task.node;
+            node.inputs_state.resize( node.inputs.size() );
+            for(size_t i=0; i < node.inputs.size(); i++)
+            {
+                node.inputs_state[i] = signature( plot_data, node.inputs[i] );
+            }
+            node.output_state = signature( plot_data, node.function->name() );
+            node.calculated = true;
+        }
+        // the next levels might depend on the failed plot
+        if( error )
+        {
+            std::rethrow_exception( error );
+        }
+    }
+}
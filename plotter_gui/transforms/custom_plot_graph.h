@@ -0,0 +1,66 @@
+#ifndef CUSTOM_PLOT_GRAPH_H
+#define CUSTOM_PLOT_GRAPH_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "custom_function.h"
+#include "PlotJuggler/plotdata.h"
+
+/**
+ * @brief Schedules the calculation of the custom plots.
+ *
+ * A custom plot can read other custom plots, as linked plot or with $$name$$.
+ * The plots are sorted in levels: each plot is in a level after the ones it reads,
+ * and the plots of the same level are independent, therefore they are calculated in parallel.
+ *
+ * The state of the inputs of each plot is remembered: a plot is calculated only if
+ * its inputs received new samples, and from scratch only if one of them was rewritten.
+ */
+class CustomPlotGraph
+{
+public:
+
+    // Calculate the custom plots whose inputs changed since the last call.
+    // The graph is rebuilt automatically when custom_plots changes.
+    void update(const CustomPlotMap& custom_plots, PlotDataMapRef& plot_data);
+
+    // Plots that depend on each other in a cycle have one level each, at the end.
+    const std::vector<std::vector<std::string>>& levels() const { return _levels; }
+
+private:
+
+    struct Signature{
+        Signature(): exists(false), generation(0), total(0) {}
+        bool exists;
+        size_t generation;
+        size_t total; // samples ever added: evicted and current ones
+        bool operator ==(const Signature& other) const
+        {
+            return exists == other.exists && generation == other.generation && total == other.total;
+        }
+        bool operator !=(const Signature& other) const { return !( *this == other ); }
+    };
+
+    struct Node{
+        Node(): calculated(false) {}
+        CustomPlotPtr function;
+        // the linked plot, followed by the channels
+        std::vector<std::string> inputs;
+        // at the end of the last calculation
+        std::vector<Signature> inputs_state;
+        Signature output_state;
+        bool calculated;
+    };
+
+    bool hasChanged(const CustomPlotMap& custom_plots) const;
+
+    void rebuild(const CustomPlotMap& custom_plots);
+
+    static Signature signature(const PlotDataMapRef& plot_data, const std::string& name);
+
+    std::map<std::string, Node> _nodes;
+    std::vector<std::vector<std::string>> _levels;
+};
+
+#endif // CUSTOM_PLOT_GRAPH_H
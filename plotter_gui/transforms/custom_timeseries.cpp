@@ -4,8 +4,15 @@
 CustomTimeseries::CustomTimeseries(const PlotData *source_data,
                                    const SnippetData &snippet,
                                    PlotDataMapRef &mapped_data):
-    TimeseriesQwt( source_data, &_cached_data ),
-    _transform(source_data->name(), snippet),
+    TimeseriesQwt( source_data,
+                   TransformCache::get( source_data,
+                                        ( "snippet:" + snippet.name + '\n' +
+                                          snippet.globalVars + '\n' + snippet.equation ).toStdString(),
+                                        [source_data, &snippet]()
+                                        {
+                                            return std::make_shared<SharedData>( source_data->name(),
+                                                                                 snippet );
+                                        }) ),
     _mapped_data(mapped_data)
 {
     updateCache();
@@ -13,14 +20,21 @@ CustomTimeseries::CustomTimeseries(const PlotData *source_data,
 
 bool CustomTimeseries::updateCache()
 {
+    PlotData& cached_data = _transformed->data;
+
     if(_source_data->size() == 0)
     {
-        _cached_data.clear();
+        cached_data.clear();
         _bounding_box = QRectF();
         return true;
     }
 
-    _transform.calculate( _mapped_data, &_cached_data );
+    // nothing to do if another curve already updated the shared data
+    if( prepareIncrementalUpdate() < _source_data->size() )
+    {
+        auto& function = static_cast<SharedData*>( _transformed.get() )->function;
+        function.calculate( _mapped_data, &cached_data );
+    }
     calculateBoundingBox();
 
     return true;
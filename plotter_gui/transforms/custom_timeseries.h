@@ -15,7 +15,14 @@ public:
     bool updateCache() override;
 
 private:
-    CustomFunction _transform;
+    // the function is shared too, because snippets can have a state (global variables)
+    struct SharedData: public TransformedData
+    {
+        SharedData(const std::string& linked_plot, const SnippetData &snippet):
+            function(linked_plot, snippet) {}
+        CustomFunction function;
+    };
+
     const PlotDataMapRef& _mapped_data;
 
 };
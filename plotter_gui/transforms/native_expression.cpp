@@ -0,0 +1,1004 @@
+#include "native_expression.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <locale>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+#include <algorithm>
+
+namespace {
+
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+// number of samples processed at once by a stateless program
+const size_t BLOCK_SIZE = 256;
+
+struct Token{
+    enum Type{ NUMBER, IDENTIFIER, PUNCT, END };
+    Type type;
+    std::string text;
+    double number;
+    bool newline_before;
+};
+
+// thrown when the snippet can not be compiled; the caller falls back to QJSEngine
+struct Unsupported{};
+
+bool isIdentifierStart(char c)
+{
+    return std::isalpha( static_cast<unsigned char>(c) ) || c == '_' || c == '$';
+}
+
+bool isIdentifierChar(char c)
+{
+    return isIdentifierStart(c) || std::isdigit( static_cast<unsigned char>(c) );
+}
+
+size_t skipDigits(const std::string& text, size_t pos)
+{
+    while( pos < text.size() && std::isdigit( static_cast<unsigned char>(text[pos]) ) ) {
+        pos++;
+    }
+    return pos;
+}
+
+// end of the decimal literal that starts at pos: digits, fraction and exponent
+size_t scanNumber(const std::string& text, size_t pos)
+{
+    pos = skipDigits( text, pos );
+    if( pos < text.size() && text[pos] == '.' ) {
+        pos = skipDigits( text, pos + 1 );
+    }
+    if( pos < text.size() && (text[pos] == 'e' || text[pos] == 'E') )
+    {
+        size_t exponent = pos + 1;
+        if( exponent < text.size() && (text[exponent] == '+' || text[exponent] == '-') ) {
+            exponent++;
+        }
+        const size_t end = skipDigits( text, exponent );
+        // without digits, the "e" is not part of the number
+        if( end > exponent ) {
+            pos = end;
+        }
+    }
+    return pos;
+}
+
+std::vector<Token> tokenize(const std::string& text)
+{
+    // longest first. Operators that are valid JS, but not supported, are
+    // recognized only to reject them (otherwise "x++" would be parsed as "x + +")
+    static const char* operators[] = {
+        "===", "!==", "**", "++", "--", "<<", ">>", "=>",
+        "==", "!=", "<=", ">=", "&&", "||", "+=", "-=", "*=", "/=", "%=",
+        "+", "-", "*", "/", "%", "<", ">", "!", "?", ":",
+        "(", ")", "[", "]", ",", ";", "=", "."
+    };
+    // "===" and "!==" are rejected too: the VM has only numbers, but in JS true !== 1
+    static const std::set<std::string> rejected = { "**", "++", "--", "<<", ">>", "=>",
+                                                    "===", "!==" };
+
+    std::vector<Token> tokens;
+    bool newline = false;
+    size_t pos = 0;
+    while( pos < text.size() )
+    {
+        const char c = text[pos];
+        if( c == '\n' || c == '\r' )
+        {
+            newline = true;
+            pos++;
+            continue;
+        }
+        if( std::isspace( static_cast<unsigned char>(c) ) )
+        {
+            pos++;
+            continue;
+        }
+        if( text.compare( pos, 2, "//" ) == 0 )
+        {
+            pos = text.find( '\n', pos );
+            if( pos == std::string::npos ) {
+                pos = text.size();
+            }
+            continue;
+        }
+        if( text.compare( pos, 2, "/*" ) == 0 )
+        {
+            const size_t end = text.find( "*/", pos + 2 );
+            if( end == std::string::npos ) {
+                throw Unsupported();
+            }
+            if( text.find( '\n', pos ) < end ) {
+                newline = true;
+            }
+            pos = end + 2;
+            continue;
+        }
+
+        Token token;
+        token.newline_before = newline;
+        token.number = 0;
+        newline = false;
+
+        const bool digit_next = pos + 1 < text.size() &&
+                                std::isdigit( static_cast<unsigned char>(text[pos+1]) );
+
+        if( std::isdigit( static_cast<unsigned char>(c) ) || (c == '.' && digit_next) )
+        {
+            // only decimal literals: hexadecimal, octal and binary are left to QJSEngine.
+            // That includes the legacy octal literals like "017" (15, not 17).
+            if( c == '0' && pos + 1 < text.size() &&
+                ( digit_next || ( std::isalpha( static_cast<unsigned char>(text[pos+1]) )
+                                  && text[pos+1] != 'e' && text[pos+1] != 'E' ) ) )
+            {
+                throw Unsupported();
+            }
+            const size_t end = scanNumber( text, pos );
+            if( end == pos ) {
+                throw Unsupported();
+            }
+            token.type = Token::NUMBER;
+            token.text = text.substr( pos, end - pos );
+            // strtod would depend on LC_NUMERIC (the decimal separator is ',' in many locales)
+            std::istringstream stream( token.text );
+            stream.imbue( std::locale::classic() );
+            stream >> token.number;
+            if( stream.fail() ) {
+                throw Unsupported();
+            }
+            pos = end;
+            if( pos < text.size() && isIdentifierChar( text[pos] ) ) {
+                throw Unsupported();
+            }
+        }
+        else if( isIdentifierStart(c) )
+        {
+            const size_t start = pos;
+            while( pos < text.size() && isIdentifierChar( text[pos] ) ) {
+                pos++;
+            }
+            token.type = Token::IDENTIFIER;
+            token.text = text.substr( start, pos - start );
+        }
+        else{
+            token.type = Token::PUNCT;
+            for(const char* op: operators)
+            {
+                if( text.compare( pos, std::strlen(op), op ) == 0 )
+                {
+                    token.text = op;
+                    break;
+                }
+            }
+            if( token.text.empty() || rejected.count( token.text ) ) {
+                throw Unsupported();
+            }
+            pos += token.text.size();
+        }
+        tokens.push_back( token );
+    }
+    Token end;
+    end.type = Token::END;
+    end.number = 0;
+    end.newline_before = true;
+    tokens.push_back( end );
+    return tokens;
+}
+
+struct MathFunction{
+    NativeExpression::OpCode op;
+    int arguments; // -1 means variadic
+};
+
+const std::map<std::string, MathFunction>& mathFunctions()
+{
+    static const std::map<std::string, MathFunction> functions = {
+        {"abs",   {NativeExpression::ABS, 1}},
+        {"acos",  {NativeExpression::ACOS, 1}},
+        {"asin",  {NativeExpression::ASIN, 1}},
+        {"atan",  {NativeExpression::ATAN, 1}},
+        {"atan2", {NativeExpression::ATAN2, 2}},
+        {"cbrt",  {NativeExpression::CBRT, 1}},
+        {"ceil",  {NativeExpression::CEIL, 1}},
+        {"cos",   {NativeExpression::COS, 1}},
+        {"cosh",  {NativeExpression::COSH, 1}},
+        {"exp",   {NativeExpression::EXP, 1}},
+        {"floor", {NativeExpression::FLOOR, 1}},
+        {"hypot", {NativeExpression::HYPOT, -1}},
+        {"log",   {NativeExpression::LOG, 1}},
+        {"log10", {NativeExpression::LOG10, 1}},
+        {"log2",  {NativeExpression::LOG2, 1}},
+        {"max",   {NativeExpression::MAX, -1}},
+        {"min",   {NativeExpression::MIN, -1}},
+        {"pow",   {NativeExpression::POW, 2}},
+        {"round", {NativeExpression::ROUND, 1}},
+        {"sign",  {NativeExpression::SIGN, 1}},
+        {"sin",   {NativeExpression::SIN, 1}},
+        {"sinh",  {NativeExpression::SINH, 1}},
+        {"sqrt",  {NativeExpression::SQRT, 1}},
+        {"tan",   {NativeExpression::TAN, 1}},
+        {"tanh",  {NativeExpression::TANH, 1}},
+        {"trunc", {NativeExpression::TRUNC, 1}}
+    };
+    return functions;
+}
+
+const std::map<std::string, double>& mathConstants()
+{
+    static const std::map<std::string, double> constants = {
+        {"E",       2.718281828459045},
+        {"LN10",    2.302585092994046},
+        {"LN2",     0.6931471805599453},
+        {"LOG10E",  0.4342944819032518},
+        {"LOG2E",   1.4426950408889634},
+        {"PI",      3.141592653589793},
+        {"SQRT1_2", 0.7071067811865476},
+        {"SQRT2",   1.4142135623730951}
+    };
+    return constants;
+}
+
+// All the properties of Math. Because of "with(Math)", inside the function
+// they hide any variable with the same name.
+bool isMathProperty(const std::string& name)
+{
+    static const std::set<std::string> others = {
+        "acosh", "asinh", "atanh", "clz32", "expm1", "fround", "imul", "log1p", "random"
+    };
+    return mathFunctions().count(name) || mathConstants().count(name) || others.count(name);
+}
+
+bool isReserved(const std::string& name)
+{
+    static const std::set<std::string> reserved = {
+        "break", "case", "catch", "class", "continue", "debugger", "default", "delete",
+        "do", "else", "export", "extends", "finally", "for", "function", "if", "import",
+        "in", "instanceof", "new", "return", "super", "switch", "this", "throw", "try",
+        "typeof", "var", "void", "while", "with", "yield", "let", "const", "null",
+        "true", "false", "undefined", "NaN", "Infinity", "Math", "time", "value",
+        "CHANNEL_VALUES", "arguments", "eval"
+    };
+    return reserved.count(name) > 0;
+}
+
+inline bool truthy(double x)
+{
+    return x != 0.0 && !std::isnan(x);
+}
+
+inline double jsRound(double x)
+{
+    // Math.round rounds the halves toward +Infinity
+    const double r = std::floor(x);
+    return ( x - r >= 0.5 ) ? r + 1.0 : r;
+}
+
+inline double jsSign(double x)
+{
+    if( x > 0 ) return 1.0;
+    if( x < 0 ) return -1.0;
+    return x; // 0, -0 or NaN
+}
+
+inline double jsPow(double a, double b)
+{
+    // in C pow(1, NaN) and pow(+-1, +-Infinity) are 1, in JS they are NaN
+    return ( std::abs(a) == 1.0 && !std::isfinite(b) ) ? NaN : std::pow(a, b);
+}
+
+inline double jsMax(double a, double b)
+{
+    return ( std::isnan(a) || std::isnan(b) ) ? NaN : std::max(a, b);
+}
+
+inline double jsMin(double a, double b)
+{
+    return ( std::isnan(a) || std::isnan(b) ) ? NaN : std::min(a, b);
+}
+
+} // end namespace
+
+// Recursive descent parser that emits the instructions directly, while it parses.
+// Operators have the same precedence and associativity of JavaScript.
+class ExpressionParser
+{
+public:
+    ExpressionParser(NativeExpression& program, size_t channels_count):
+        _program(program),
+        _channels_count(channels_count),
+        _pos(0),
+        _in_function(false),
+        _returned(false)
+    {}
+
+    void parseGlobals(const std::string& text, std::vector<NativeExpression::Instruction>& code)
+    {
+        _tokens = tokenize(text);
+        _pos = 0;
+        _code = &code;
+        _in_function = false;
+        while( peek().type != Token::END )
+        {
+            parseStatement();
+        }
+    }
+
+    void parseFunction(const std::string& text)
+    {
+        _tokens = tokenize(text);
+        _pos = 0;
+        _code = &_program._code;
+        _in_function = true;
+
+        // "var" is hoisted: the local variables must be known in advance
+        for(size_t i=0; i+1 < _tokens.size(); i++)
+        {
+            if( isDeclaration( _tokens[i] ) && _tokens[i+1].type == Token::IDENTIFIER )
+            {
+                const std::string& name = _tokens[i+1].text;
+                if( isReserved(name) || isMathProperty(name) ) {
+                    throw Unsupported();
+                }
+                Variable var;
+                var.reg = newRegister( NaN );
+                var.local = true;
+                _locals[name] = var;
+            }
+        }
+
+        while( peek().type != Token::END )
+        {
+            if( _returned ) {
+                // unreachable code is not worth supporting
+                throw Unsupported();
+            }
+            parseStatement();
+        }
+
+        bool stateless = true;
+        for(const auto& it: _globals)
+        {
+            if( it.second.read_before_assigned && it.second.assigned ) {
+                stateless = false;
+            }
+        }
+        _program._stateless = stateless;
+    }
+
+private:
+    struct Variable{
+        Variable(): reg(0), local(false), assigned(false), read_before_assigned(false) {}
+        size_t reg;
+        bool local;
+        bool assigned;
+        bool read_before_assigned;
+    };
+
+    static bool isDeclaration(const Token& token)
+    {
+        return token.type == Token::IDENTIFIER &&
+               (token.text == "var" || token.text == "let" || token.text == "const");
+    }
+
+    const Token& peek() const { return _tokens[_pos]; }
+
+    bool peekPunct(const char* text) const
+    {
+        return peek().type == Token::PUNCT && peek().text == text;
+    }
+
+    bool acceptPunct(const char* text)
+    {
+        if( peekPunct(text) )
+        {
+            _pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void expectPunct(const char* text)
+    {
+        if( !acceptPunct(text) ) {
+            throw Unsupported();
+        }
+    }
+
+    std::string expectIdentifier()
+    {
+        if( peek().type != Token::IDENTIFIER ) {
+            throw Unsupported();
+        }
+        return _tokens[_pos++].text;
+    }
+
+    // automatic semicolon insertion
+    void endOfStatement()
+    {
+        if( acceptPunct(";") ) {
+            return;
+        }
+        if( peek().type != Token::END && !peek().newline_before ) {
+            throw Unsupported();
+        }
+    }
+
+    size_t newRegister(double initial_value)
+    {
+        _program._registers.push_back( initial_value );
+        return _program._registers.size() - 1;
+    }
+
+    size_t constant(double value)
+    {
+        return newRegister( value );
+    }
+
+    size_t emit(NativeExpression::OpCode op, size_t a, size_t b = 0, size_t c = 0)
+    {
+        const size_t dst = newRegister( NaN );
+        _code->push_back( {op, dst, a, b, c} );
+        return dst;
+    }
+
+    // the variable that a name refers to, when it is written
+    Variable* lookup(const std::string& name)
+    {
+        if( _in_function )
+        {
+            auto local = _locals.find(name);
+            if( local != _locals.end() ) {
+                return &local->second;
+            }
+        }
+        auto global = _globals.find(name);
+        return ( global != _globals.end() ) ? &global->second : nullptr;
+    }
+
+    void parseStatement()
+    {
+        if( acceptPunct(";") ) {
+            return;
+        }
+        const Token& token = peek();
+        if( token.type == Token::IDENTIFIER && token.text == "return" )
+        {
+            if( !_in_function ) {
+                throw Unsupported();
+            }
+            _pos++;
+            if( peek().newline_before || peekPunct(";") ) {
+                // "return" alone returns undefined
+                throw Unsupported();
+            }
+            _program._result_register = parseExpression();
+            _program._has_result = true;
+            _returned = true;
+            endOfStatement();
+            return;
+        }
+        if( isDeclaration(token) )
+        {
+            _pos++;
+            do{
+                const std::string name = expectIdentifier();
+                if( isReserved(name) || (_in_function && isMathProperty(name)) ) {
+                    throw Unsupported();
+                }
+                Variable* var = lookup(name);
+                if( !var )
+                {
+                    // global variable
+                    Variable new_var;
+                    new_var.reg = newRegister( NaN );
+                    var = &( _globals[name] = new_var );
+                }
+                // without initializer the variable is undefined, that can not be represented
+                // by a number (in JS undefined == undefined, while NaN != NaN)
+                expectPunct("=");
+                assign( *var, parseAssignmentExpression() );
+            } while( acceptPunct(",") );
+            endOfStatement();
+            return;
+        }
+        if( token.type == Token::IDENTIFIER && _pos + 1 < _tokens.size() &&
+            _tokens[_pos+1].type == Token::PUNCT )
+        {
+            const std::string& op = _tokens[_pos+1].text;
+            if( op == "=" || op == "+=" || op == "-=" || op == "*=" || op == "/=" || op == "%=" )
+            {
+                const std::string name = token.text;
+                _pos += 2;
+                if( isReserved(name) || (_in_function && isMathProperty(name)) ) {
+                    throw Unsupported();
+                }
+                Variable* var = lookup(name);
+                if( !var )
+                {
+                    if( op != "=" ) {
+                        throw Unsupported();
+                    }
+                    // implicit declaration of a global variable
+                    Variable new_var;
+                    new_var.reg = newRegister( NaN );
+                    var = &( _globals[name] = new_var );
+                }
+                size_t result = parseAssignmentExpression();
+                if( op != "=" )
+                {
+                    const size_t previous = read( *var );
+                    const NativeExpression::OpCode code =
+                            (op == "+=") ? NativeExpression::ADD :
+                            (op == "-=") ? NativeExpression::SUB :
+                            (op == "*=") ? NativeExpression::MUL :
+                            (op == "/=") ? NativeExpression::DIV : NativeExpression::MOD;
+                    result = emit( code, previous, result );
+                }
+                assign( *var, result );
+                endOfStatement();
+                return;
+            }
+        }
+        // an expression without side effects: it is validated, but it does nothing
+        parseExpression();
+        endOfStatement();
+    }
+
+    void assign(Variable& var, size_t value)
+    {
+        _code->push_back( {NativeExpression::COPY, var.reg, value, 0, 0} );
+        if( _in_function ) {
+            var.assigned = true;
+        }
+    }
+
+    size_t read(Variable& var)
+    {
+        if( _in_function && !var.assigned )
+        {
+            if( var.local ) {
+                // undefined
+                throw Unsupported();
+            }
+            var.read_before_assigned = true;
+        }
+        return var.reg;
+    }
+
+    size_t parseExpression()
+    {
+        size_t result = parseAssignmentExpression();
+        while( acceptPunct(",") ) {
+            result = parseAssignmentExpression();
+        }
+        return result;
+    }
+
+    size_t parseAssignmentExpression()
+    {
+        const size_t result = parseConditional();
+        const Token& token = peek();
+        if( token.type == Token::PUNCT && token.text.back() == '=' &&
+            token.text != "==" && token.text != "!=" &&
+            token.text != "<=" && token.text != ">=" )
+        {
+            // assignments are allowed only as statements
+            throw Unsupported();
+        }
+        return result;
+    }
+
+    size_t parseConditional()
+    {
+        const size_t condition = parseBinary(0);
+        if( acceptPunct("?") )
+        {
+            const size_t if_true = parseAssignmentExpression();
+            expectPunct(":");
+            const size_t if_false = parseAssignmentExpression();
+            return emit( NativeExpression::SELECT, condition, if_true, if_false );
+        }
+        return condition;
+    }
+
+    size_t parseBinary(int level)
+    {
+        struct Operator{
+            const char* text;
+            NativeExpression::OpCode op;
+        };
+        static const std::vector<std::vector<Operator>> levels = {
+            { {"||", NativeExpression::OR} },
+            { {"&&", NativeExpression::AND} },
+            { {"==", NativeExpression::EQ}, {"!=", NativeExpression::NE} },
+            { {"<", NativeExpression::LT}, {"<=", NativeExpression::LE},
+              {">", NativeExpression::GT}, {">=", NativeExpression::GE} },
+            { {"+", NativeExpression::ADD}, {"-", NativeExpression::SUB} },
+            { {"*", NativeExpression::MUL}, {"/", NativeExpression::DIV},
+              {"%", NativeExpression::MOD} }
+        };
+
+        if( level == static_cast<int>(levels.size()) ) {
+            return parseUnary();
+        }
+        size_t left = parseBinary( level + 1 );
+        while( true )
+        {
+            bool found = false;
+            for(const Operator& op: levels[level])
+            {
+                if( acceptPunct(op.text) )
+                {
+                    const size_t right = parseBinary( level + 1 );
+                    left = emit( op.op, left, right );
+                    found = true;
+                    break;
+                }
+            }
+            if( !found ) {
+                return left;
+            }
+        }
+    }
+
+    size_t parseUnary()
+    {
+        if( acceptPunct("-") ) {
+            return emit( NativeExpression::NEG, parseUnary() );
+        }
+        if( acceptPunct("+") ) {
+            return parseUnary();
+        }
+        if( acceptPunct("!") ) {
+            return emit( NativeExpression::NOT, parseUnary() );
+        }
+        return parsePrimary();
+    }
+
+    size_t parseCall(const std::string& name)
+    {
+        auto it = mathFunctions().find(name);
+        if( it == mathFunctions().end() ) {
+            throw Unsupported();
+        }
+        const MathFunction& function = it->second;
+
+        expectPunct("(");
+        std::vector<size_t> args;
+        if( !acceptPunct(")") )
+        {
+            do{
+                args.push_back( parseAssignmentExpression() );
+            } while( acceptPunct(",") );
+            expectPunct(")");
+        }
+
+        if( function.arguments == -1 )
+        {
+            if( function.op == NativeExpression::HYPOT )
+            {
+                // Math.hypot() is 0 and Math.hypot(x) is |x|
+                if( args.empty() ) {
+                    return constant( 0.0 );
+                }
+                if( args.size() == 1 ) {
+                    return emit( NativeExpression::ABS, args[0] );
+                }
+            }
+            if( args.empty() ) {
+                return constant( function.op == NativeExpression::MAX ?
+                                 -std::numeric_limits<double>::infinity() :
+                                  std::numeric_limits<double>::infinity() );
+            }
+            // hypot(a, b, c) is hypot(hypot(a, b), c): infinite wins over NaN, as in JS
+            size_t result = emit( NativeExpression::COPY, args[0] );
+            for(size_t i=1; i < args.size(); i++) {
+                result = emit( function.op, result, args[i] );
+            }
+            return result;
+        }
+        // missing arguments are undefined, extra ones are ignored
+        while( args.size() < static_cast<size_t>(function.arguments) ) {
+            args.push_back( constant( NaN ) );
+        }
+        return emit( function.op, args[0], args.size() > 1 ? args[1] : 0 );
+    }
+
+    size_t parseMathMember(const std::string& name)
+    {
+        auto it = mathConstants().find(name);
+        if( it != mathConstants().end() ) {
+            return constant( it->second );
+        }
+        return parseCall( name );
+    }
+
+    size_t parsePrimary()
+    {
+        const Token token = peek();
+        if( token.type == Token::NUMBER )
+        {
+            _pos++;
+            return constant( token.number );
+        }
+        if( acceptPunct("(") )
+        {
+            const size_t result = parseExpression();
+            expectPunct(")");
+            return result;
+        }
+        if( token.type != Token::IDENTIFIER ) {
+            throw Unsupported();
+        }
+        _pos++;
+        const std::string& name = token.text;
+
+        if( _in_function && isMathProperty(name) ) {
+            return parseMathMember( name );
+        }
+        if( name == "Math" )
+        {
+            expectPunct(".");
+            return parseMathMember( expectIdentifier() );
+        }
+        if( name == "NaN" ) {
+            return constant( NaN );
+        }
+        if( name == "Infinity" ) {
+            return constant( std::numeric_limits<double>::infinity() );
+        }
+        if( name == "true" || name == "false" ) {
+            return constant( name == "true" ? 1.0 : 0.0 );
+        }
+        if( _in_function && name == "time" ) {
+            return 0;
+        }
+        if( _in_function && name == "value" ) {
+            return 1;
+        }
+        if( _in_function && name == "CHANNEL_VALUES" )
+        {
+            expectPunct("[");
+            const Token index = peek();
+            if( index.type != Token::NUMBER || index.number != std::floor(index.number) ||
+                index.number < 0 || index.number >= static_cast<double>(_channels_count) )
+            {
+                throw Unsupported();
+            }
+            _pos++;
+            expectPunct("]");
+            return 2 + static_cast<size_t>(index.number);
+        }
+        if( isReserved(name) ) {
+            throw Unsupported();
+        }
+        Variable* var = lookup(name);
+        if( !var ) {
+            // ReferenceError
+            throw Unsupported();
+        }
+        if( peekPunct("(") || peekPunct(".") || peekPunct("[") ) {
+            throw Unsupported();
+        }
+        return read( *var );
+    }
+
+    NativeExpression& _program;
+    const size_t _channels_count;
+    std::vector<Token> _tokens;
+    size_t _pos;
+    std::vector<NativeExpression::Instruction>* _code;
+    bool _in_function;
+    bool _returned;
+    std::map<std::string, Variable> _globals;
+    std::map<std::string, Variable> _locals;
+};
+
+NativeExpression::NativeExpression():
+    _result_register(0),
+    _has_result(false),
+    _stateless(true)
+{}
+
+std::unique_ptr<NativeExpression> NativeExpression::compile(const std::string& global_vars,
+                                                            const std::string& function,
+                                                            size_t channels_count)
+{
+    std::unique_ptr<NativeExpression> program( new NativeExpression );
+    program->_registers.assign( 2 + channels_count, NaN );
+
+    try{
+        ExpressionParser parser( *program, channels_count );
+        std::vector<Instruction> init_code;
+        parser.parseGlobals( global_vars, init_code );
+        parser.parseFunction( function );
+        // the global variables are initialized once, like QJSEngine does
+        program->execute( init_code, program->_registers.data() );
+    }
+    catch( Unsupported& )
+    {
+        return std::unique_ptr<NativeExpression>();
+    }
+    return program;
+}
+
+void NativeExpression::evaluate(const double* time, const double* value,
+                                const std::vector<const double*>& channels,
+                                size_t count, double* result)
+{
+    const size_t num_registers = _registers.size();
+    const size_t inputs = 2 + channels.size();
+
+    if( !_stateless )
+    {
+        double* regs = _registers.data();
+        for(size_t i=0; i < count; i++)
+        {
+            regs[0] = time[i];
+            regs[1] = value[i];
+            for(size_t c=0; c < channels.size(); c++) {
+                regs[2+c] = channels[c][i];
+            }
+            execute( _code, regs );
+            result[i] = _has_result ? regs[_result_register] : NaN;
+        }
+        return;
+    }
+
+    // column-wise: each register is a column of BLOCK_SIZE values
+    _block_registers.resize( num_registers * BLOCK_SIZE );
+    double* regs = _block_registers.data();
+
+    for(size_t offset = 0; offset < count; offset += BLOCK_SIZE)
+    {
+        const size_t n = std::min( BLOCK_SIZE, count - offset );
+
+        std::copy( time + offset, time + offset + n, regs );
+        std::copy( value + offset, value + offset + n, regs + BLOCK_SIZE );
+        for(size_t c=0; c < channels.size(); c++) {
+            std::copy( channels[c] + offset, channels[c] + offset + n, regs + (2+c)*BLOCK_SIZE );
+        }
+        for(size_t r = inputs; r < num_registers; r++) {
+            std::fill( regs + r*BLOCK_SIZE, regs + r*BLOCK_SIZE + n, _registers[r] );
+        }
+
+        executeBlock( _code, regs, n );
+
+        if( _has_result ) {
+            const double* res = regs + _result_register*BLOCK_SIZE;
+            std::copy( res, res + n, result + offset );
+        }
+        else{
+            std::fill( result + offset, result + offset + n, NaN );
+        }
+        // the variables keep the value of the last sample
+        for(size_t r = inputs; r < num_registers; r++) {
+            _registers[r] = regs[ r*BLOCK_SIZE + n - 1 ];
+        }
+    }
+}
+
+void NativeExpression::execute(const std::vector<Instruction>& code, double* R)
+{
+    for(const Instruction& in: code)
+    {
+        const double a = R[in.a];
+        const double b = R[in.b];
+        double& d = R[in.dst];
+        switch( in.op )
+        {
+        case COPY:   d = a; break;
+        case NEG:    d = -a; break;
+        case NOT:    d = truthy(a) ? 0.0 : 1.0; break;
+        case ADD:    d = a + b; break;
+        case SUB:    d = a - b; break;
+        case MUL:    d = a * b; break;
+        case DIV:    d = a / b; break;
+        case MOD:    d = std::fmod(a, b); break;
+        case LT:     d = a < b; break;
+        case LE:     d = a <= b; break;
+        case GT:     d = a > b; break;
+        case GE:     d = a >= b; break;
+        case EQ:     d = a == b; break;
+        case NE:     d = a != b; break;
+        case AND:    d = truthy(a) ? b : a; break;
+        case OR:     d = truthy(a) ? a : b; break;
+        case SELECT: d = truthy(a) ? b : R[in.c]; break;
+        case ABS:    d = std::abs(a); break;
+        case ACOS:   d = std::acos(a); break;
+        case ASIN:   d = std::asin(a); break;
+        case ATAN:   d = std::atan(a); break;
+        case ATAN2:  d = std::atan2(a, b); break;
+        case CBRT:   d = std::cbrt(a); break;
+        case CEIL:   d = std::ceil(a); break;
+        case COS:    d = std::cos(a); break;
+        case COSH:   d = std::cosh(a); break;
+        case EXP:    d = std::exp(a); break;
+        case FLOOR:  d = std::floor(a); break;
+        case HYPOT:  d = std::hypot(a, b); break;
+        case LOG:    d = std::log(a); break;
+        case LOG10:  d = std::log10(a); break;
+        case LOG2:   d = std::log2(a); break;
+        case MAX:    d = jsMax(a, b); break;
+        case MIN:    d = jsMin(a, b); break;
+        case POW:    d = jsPow(a, b); break;
+        case ROUND:  d = jsRound(a); break;
+        case SIGN:   d = jsSign(a); break;
+        case SIN:    d = std::sin(a); break;
+        case SINH:   d = std::sinh(a); break;
+        case SQRT:   d = std::sqrt(a); break;
+        case TAN:    d = std::tan(a); break;
+        case TANH:   d = std::tanh(a); break;
+        case TRUNC:  d = std::trunc(a); break;
+        }
+    }
+}
+
+// The switch is resolved once per instruction and the loops over the
+// samples are simple enough to be vectorized by the compiler.
+#define PJ_BLOCK_LOOP(EXPR) \
+    for(size_t i=0; i < count; i++) { d[i] = (EXPR); } break;
+
+void NativeExpression::executeBlock(const std::vector<Instruction>& code, double* R, size_t count)
+{
+    for(const Instruction& in: code)
+    {
+        const double* a = R + in.a * BLOCK_SIZE;
+        const double* b = R + in.b * BLOCK_SIZE;
+        const double* c = R + in.c * BLOCK_SIZE;
+        double* d = R + in.dst * BLOCK_SIZE;
+        switch( in.op )
+        {
+        case COPY:   PJ_BLOCK_LOOP( a[i] )
+        case NEG:    PJ_BLOCK_LOOP( -a[i] )
+        case NOT:    PJ_BLOCK_LOOP( truthy(a[i]) ? 0.0 : 1.0 )
+        case ADD:    PJ_BLOCK_LOOP( a[i] + b[i] )
+        case SUB:    PJ_BLOCK_LOOP( a[i] - b[i] )
+        case MUL:    PJ_BLOCK_LOOP( a[i] * b[i] )
+        case DIV:    PJ_BLOCK_LOOP( a[i] / b[i] )
+        case MOD:    PJ_BLOCK_LOOP( std::fmod(a[i], b[i]) )
+        case LT:     PJ_BLOCK_LOOP( a[i] < b[i] )
+        case LE:     PJ_BLOCK_LOOP( a[i] <= b[i] )
+        case GT:     PJ_BLOCK_LOOP( a[i] > b[i] )
+        case GE:     PJ_BLOCK_LOOP( a[i] >= b[i] )
+        case EQ:     PJ_BLOCK_LOOP( a[i] == b[i] )
+        case NE:     PJ_BLOCK_LOOP( a[i] != b[i] )
+        case AND:    PJ_BLOCK_LOOP( truthy(a[i]) ? b[i] : a[i] )
+        case OR:     PJ_BLOCK_LOOP( truthy(a[i]) ? a[i] : b[i] )
+        case SELECT: PJ_BLOCK_LOOP( truthy(a[i]) ? b[i] : c[i] )
+        case ABS:    PJ_BLOCK_LOOP( std::abs(a[i]) )
+        case ACOS:   PJ_BLOCK_LOOP( std::acos(a[i]) )
+        case ASIN:   PJ_BLOCK_LOOP( std::asin(a[i]) )
+        case ATAN:   PJ_BLOCK_LOOP( std::atan(a[i]) )
+        case ATAN2:  PJ_BLOCK_LOOP( std::atan2(a[i], b[i]) )
+        case CBRT:   PJ_BLOCK_LOOP( std::cbrt(a[i]) )
+        case CEIL:   PJ_BLOCK_LOOP( std::ceil(a[i]) )
+        case COS:    PJ_BLOCK_LOOP( std::cos(a[i]) )
+        case COSH:   PJ_BLOCK_LOOP( std::cosh(a[i]) )
+        case EXP:    PJ_BLOCK_LOOP( std::exp(a[i]) )
+        case FLOOR:  PJ_BLOCK_LOOP( std::floor(a[i]) )
+        case HYPOT:  PJ_BLOCK_LOOP( std::hypot(a[i], b[i]) )
+        case LOG:    PJ_BLOCK_LOOP( std::log(a[i]) )
+        case LOG10:  PJ_BLOCK_LOOP( std::log10(a[i]) )
+        case LOG2:   PJ_BLOCK_LOOP( std::log2(a[i]) )
+        case MAX:    PJ_BLOCK_LOOP( jsMax(a[i], b[i]) )
+        case MIN:    PJ_BLOCK_LOOP( jsMin(a[i], b[i]) )
+        case POW:    PJ_BLOCK_LOOP( jsPow(a[i], b[i]) )
+        case ROUND:  PJ_BLOCK_LOOP( jsRound(a[i]) )
+        case SIGN:   PJ_BLOCK_LOOP( jsSign(a[i]) )
+        case SIN:    PJ_BLOCK_LOOP( std::sin(a[i]) )
+        case SINH:   PJ_BLOCK_LOOP( std::sinh(a[i]) )
+        case SQRT:   PJ_BLOCK_LOOP( std::sqrt(a[i]) )
+        case TAN:    PJ_BLOCK_LOOP( std::tan(a[i]) )
+        case TANH:   PJ_BLOCK_LOOP( std::tanh(a[i]) )
+        case TRUNC:  PJ_BLOCK_LOOP( std::trunc(a[i]) )
+        }
+    }
+}
+
+#undef PJ_BLOCK_LOOP
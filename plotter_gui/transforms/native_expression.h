@@ -0,0 +1,80 @@
+#ifndef NATIVE_EXPRESSION_H
+#define NATIVE_EXPRESSION_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Compiled version of the snippets that use only a simple subset of JavaScript:
+ *
+ * - numbers, arithmetic, comparison (but not "===" and "!==") and logical operators,
+ *   the ternary operator;
+ * - the functions and constants of Math (with or without the "Math." prefix);
+ * - "time", "value" and the channels (CHANNEL_VALUES[N]);
+ * - variables declared in the global section with "var" and an initial value,
+ *   and assignments in the function.
+ *
+ * Since there are only numbers, anything that depends on the booleans or on
+ * undefined being different types is rejected.
+ *
+ * The code is compiled into a list of instructions that work on registers.
+ * When the function has no state (no variable keeps its value from one sample to the next)
+ * each instruction is applied to a block of samples at once.
+ *
+ * Anything else (user defined functions, objects, strings, control flow...) is rejected
+ * by compile(): those snippets are executed by QJSEngine, as before.
+ */
+class NativeExpression
+{
+public:
+
+    // Return nullptr if the snippet uses constructs that are not supported.
+    // "function" is the body of calc(time, value, CHANNEL_VALUES).
+    static std::unique_ptr<NativeExpression> compile(const std::string& global_vars,
+                                                     const std::string& function,
+                                                     size_t channels_count);
+
+    // Evaluate "count" samples. There is one column of values for each channel.
+    // The state of the variables is kept between calls.
+    void evaluate(const double* time, const double* value,
+                  const std::vector<const double*>& channels,
+                  size_t count, double* result);
+
+    bool isStateless() const { return _stateless; }
+
+    enum OpCode{
+        COPY, NEG, NOT, ADD, SUB, MUL, DIV, MOD,
+        LT, LE, GT, GE, EQ, NE, AND, OR, SELECT,
+        ABS, ACOS, ASIN, ATAN, ATAN2, CBRT, CEIL, COS, COSH, EXP, FLOOR, HYPOT,
+        LOG, LOG10, LOG2, MAX, MIN, POW, ROUND, SIGN, SIN, SINH, SQRT, TAN, TANH, TRUNC
+    };
+
+    struct Instruction{
+        OpCode op;
+        size_t dst;
+        size_t a;
+        size_t b;
+        size_t c;
+    };
+
+private:
+    friend class ExpressionParser;
+
+    NativeExpression();
+
+    void execute(const std::vector<Instruction>& code, double* registers);
+
+    void executeBlock(const std::vector<Instruction>& code, double* registers, size_t count);
+
+    // registers 0 and 1 are time and value, followed by the channels
+    std::vector<double> _registers;
+    std::vector<Instruction> _code;
+    size_t _result_register;
+    bool _has_result;
+    bool _stateless;
+
+    std::vector<double> _block_registers;
+};
+
+#endif // NATIVE_EXPRESSION_H
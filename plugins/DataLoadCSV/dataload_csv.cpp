@@ -142,6 +142,12 @@ PlotDataMapRef DataLoadCSV::readDataFromFile(const QString &file_name, bool use_
         }
     }
 
+    // every column has at most one sample per line
+    for (PlotData* plot: plots_vector)
+    {
+        plot->reserve( std::max( tot_lines, 0 ) );
+    }
+
     //-----------------
     double prev_time = - std::numeric_limits<double>::max();
     bool monotonic_warning = false;
@@ -216,6 +222,20 @@ PlotDataMapRef DataLoadCSV::readDataFromFile(const QString &file_name, bool use_
         progress_dialog.cancel();
         plot_data.numeric.clear();
     }
+    else if( !plots_vector.empty() )
+    {
+        // the columns without missing values have the same timestamps: store them only once
+        PlotData* reference = *std::max_element( plots_vector.begin(), plots_vector.end(),
+                                                 [](const PlotData* a, const PlotData* b)
+                                                 { return a->size() < b->size(); } );
+        for (PlotData* plot: plots_vector)
+        {
+            if( plot != reference )
+            {
+                plot->shareTimeColumnWith( *reference );
+            }
+        }
+    }
 
     if( monotonic_warning )
     {
@@ -42,17 +42,29 @@ PlotDataMapRef DataLoadULog::readDataFromFile(const QString &file_name, bool)
         const std::string& sucsctiption_name =  it.first;
         const ULogParser::Timeseries& timeseries = it.second;
 
+        // all the fields of a subscription share the same timestamps
+        std::vector<double> msg_times( timeseries.timestamps.size() );
+        for( size_t i=0; i < msg_times.size(); i++ )
+        {
+            msg_times[i] = static_cast<double>(timeseries.timestamps[i]) * 0.000001;
+        }
+
+        PlotData* reference = nullptr;
+
         for (const auto& data: timeseries.data )
         {
             std::string series_name = sucsctiption_name + data.first;
 
             auto series = plot_data.addNumeric( series_name );
 
-            for( size_t i=0; i < data.second.size(); i++ )
+            const size_t count = std::min( msg_times.size(), data.second.size() );
+            series->second.reserve( count );
+            series->second.pushBackBatch( msg_times.data(), data.second.data(), count );
+
+            // store the time column only once (unless invalid values were skipped)
+            if( !reference || !series->second.shareTimeColumnWith( *reference ) )
             {
-                double msg_time = static_cast<double>(timeseries.timestamps[i]) * 0.000001;
-                PlotData::Point point( msg_time, data.second[i] );
-                series->second.pushBack( point );
+                reference = &series->second;
             }
         }
     }
@@ -41,8 +41,7 @@ DataStreamSample::DataStreamSample()
 
         const std::string name_str = name.toStdString();
 
-        dataMap().addNumeric(name_str);
-        _parameters.insert( std::make_pair( name_str, param) );
+        _parameters.push_back( std::make_pair( registerNumericSeries(name_str), param) );
     }
     dataMap().addNumeric("empty");
 }
@@ -80,24 +79,23 @@ bool DataStreamSample::xmlLoadState(QDomElement &parent_element)
 
 void DataStreamSample::pushSingleCycle()
 {
-    std::lock_guard<std::mutex> lock( mutex() );
-
     using namespace std::chrono;
     static std::chrono::high_resolution_clock::time_point initial_time = high_resolution_clock::now();
     const double offset = duration_cast< duration<double>>( initial_time.time_since_epoch() ).count() ;
 
     auto now =  high_resolution_clock::now();
-    for (auto& it: dataMap().numeric )
-    {
-        if( it.first == "empty") continue;
-        auto par = _parameters[it.first];
+    const double t = duration_cast< duration<double>>( now - initial_time ).count() ;
 
-        auto& plot = it.second;
-        const double t = duration_cast< duration<double>>( now - initial_time ).count() ;
-        double y =  par.A*sin(par.B*t + par.C) + par.D*t*0.05;
+    SampleBatch batch;
+    batch.reserve( _parameters.size() );
 
-        plot.pushBack( PlotData::Point( t + offset, y ) );
+    for (const auto& it: _parameters )
+    {
+        const Parameters& par = it.second;
+        double y =  par.A*sin(par.B*t + par.C) + par.D*t*0.05;
+        batch.push_back( { it.first, t + offset, y } );
     }
+    pushBatch( batch );
 }
 
 void DataStreamSample::loop()
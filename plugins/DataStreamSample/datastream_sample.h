@@ -44,7 +44,7 @@ private:
 
     bool _running;
 
-    std::map<std::string,Parameters> _parameters;
+    std::vector<std::pair<SeriesHandle,Parameters>> _parameters;
 
     void pushSingleCycle();
 };
@@ -16,6 +16,7 @@
 #include "../shape_shifter_factory.hpp"
 #include "../rule_editing.h"
 #include "../dialog_with_itemlist.h"
+#include "../series_handle_cache.hpp"
 
 DataLoadROS::DataLoadROS()
 {
@@ -188,6 +189,15 @@ PlotDataMapRef DataLoadROS::readDataFromFile(const QString &file_name, bool use_
     progress_dialog.setRange(0, bag_view_selected.size()-1);
     progress_dialog.show();
 
+    // number of messages per topic, used to preallocate the series
+    std::unordered_map<std::string, size_t> topic_msg_count;
+    std::unordered_map<std::string, SeriesHandleCache> handle_caches;
+    for(const auto& topic: topic_selected)
+    {
+        rosbag::View topic_view( *_bag, rosbag::TopicQuery(topic) );
+        topic_msg_count[topic] = topic_view.size();
+    }
+
     PlotDataMapRef plot_map;
 
     FlatMessage flat_container;
@@ -199,7 +209,6 @@ PlotDataMapRef DataLoadROS::readDataFromFile(const QString &file_name, bool use_
     std::unordered_set<std::string> warning_cancellation;
     std::unordered_set<std::string> warning_max_arraysize;
     int msg_count = 0;
-    std::string prefixed_name;
     QElapsedTimer timer;
     timer.start();
 
@@ -252,27 +261,23 @@ PlotDataMapRef DataLoadROS::readDataFromFile(const QString &file_name, bool use_
             }
         }
 
-        for(const auto& it: renamed_values )
-        {
-            const auto& field_name = it.first;
-
-            if( prefix.empty() == false)
-            {
-                StrCat(prefix, field_name, prefixed_name);
-            }
-            const std::string* key_ptr = prefix.empty() ? &field_name : &prefixed_name;
+        SeriesHandleCache& handle_cache = handle_caches[topic_name];
 
+        for(size_t field_index = 0; field_index < renamed_values.size(); field_index++ )
+        {
+            const auto& it = renamed_values[field_index];
             const RosIntrospection::Variant& value = it.second;
 
-            auto plot_pair = plot_map.numeric.find( *key_ptr );
-            if( (plot_pair == plot_map.numeric.end()) )
-            {
-                plot_pair = plot_map.addNumeric( *key_ptr );
-            }
+            auto handle = handle_cache.get( plot_map, field_index, prefix, it.first );
+            PlotData& plot_data = plot_map.numericSeries( handle );
+            const std::string* key_ptr = &plot_data.name();
 
-            PlotData& plot_data = plot_pair->second;
             size_t data_size = plot_data.size();
-            if( data_size > 0 )
+            if( data_size == 0 )
+            {
+              plot_data.reserve( topic_msg_count[topic_name] );
+            }
+            else
             {
               const double last_time = plot_data.back().x;
               if( msg_time < last_time)
@@ -316,6 +321,20 @@ PlotDataMapRef DataLoadROS::readDataFromFile(const QString &file_name, bool use_
         } //end of for renamed_value
     }
 
+    // fields of the same message have the same timestamps: store them only once
+    for(const auto& it: handle_caches)
+    {
+        PlotData* reference = nullptr;
+        it.second.forEachHandle( [&](PlotDataMapRef::SeriesHandle handle)
+        {
+            PlotData& plot_data = plot_map.numericSeries( handle );
+            if( !reference || !plot_data.shareTimeColumnWith( *reference ) )
+            {
+                reference = &plot_data;
+            }
+        });
+    }
+
     storeMessageInstancesAsUserDefined(plot_map, prefix);
 
     qDebug() << "The loading operation took" << timer.elapsed() << "milliseconds";
@@ -124,9 +124,12 @@ void DataStreamROS::topicCallback(const topic_tools::ShapeShifter::ConstPtr& msg
         user_defined_data.pushBack( PlotDataAny::Point(msg_time, nonstd::any(std::move(buffer)) ));
     }
 
-    for(auto& it: renamed_value )
+    SeriesHandleCache& handle_cache = _handle_cache[topic_name];
+    PlotDataMapRef& plot_map = dataMap();
+
+    for(size_t field_index = 0; field_index < renamed_value.size(); field_index++ )
     {
-        const std::string key = ( _prefix + it.first  );
+        const auto& it = renamed_value[field_index];
         const auto& value = it.second;
         double val_d = 0.0;
 
@@ -153,12 +156,8 @@ void DataStreamROS::topicCallback(const topic_tools::ShapeShifter::ConstPtr& msg
             }
         }
 
-        auto plot_it = dataMap().numeric.find(key);
-        if( plot_it == dataMap().numeric.end())
-        {
-            plot_it = dataMap().addNumeric( key );
-        }
-        plot_it->second.pushBack( PlotData::Point(msg_time, val_d) );
+        auto handle = handle_cache.get( plot_map, field_index, _prefix, it.first );
+        plot_map.numericSeries( handle ).pushBack( PlotData::Point(msg_time, val_d) );
     }
 
     //------------------------------
@@ -363,6 +362,8 @@ bool DataStreamROS::start()
         std::lock_guard<std::mutex> lock( mutex() );
         dataMap().numeric.clear();
         dataMap().user_defined.clear();
+        dataMap().clearHandles();
+        _handle_cache.clear();
     }
     _initial_time = std::numeric_limits<double>::max();
 
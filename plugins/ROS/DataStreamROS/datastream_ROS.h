@@ -9,6 +9,7 @@
 #include "PlotJuggler/datastreamer_base.h"
 #include <ros_type_introspection/ros_introspection.hpp>
 #include <rosgraph_msgs/Clock.h>
+#include "../series_handle_cache.hpp"
 
 class  DataStreamROS: public DataStreamer
 {
@@ -64,6 +65,8 @@ private:
 
     std::map<std::string, int> _msg_index;
 
+    std::unordered_map<std::string, SeriesHandleCache> _handle_cache;
+
     QStringList _default_topic_names;
 
     std::unique_ptr<RosIntrospection::Parser> _parser;
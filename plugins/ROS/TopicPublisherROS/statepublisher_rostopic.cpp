@@ -202,7 +202,8 @@ void TopicPublisherROS::broadcastTF(double current_time)
         }
 
          const PlotDataAny* tf_data = &plot_any;
-         int last_index = tf_data->getIndexFromX( current_time );
+         PlotDataAny::Cursor& cursor = _topic_cursors[topic_name];
+         int last_index = tf_data->getIndexFromX( current_time, cursor );
          if( last_index < 0)
          {
              continue;
@@ -210,7 +211,8 @@ void TopicPublisherROS::broadcastTF(double current_time)
 
          std::vector<uint8_t> raw_buffer;
          // 1 second in the past (to be configurable in the future
-         int initial_index = tf_data->getIndexFromX( current_time - 2.0 );
+         PlotDataAny::Cursor initial_cursor = cursor;
+         int initial_index = tf_data->getIndexFromX( current_time - 2.0, initial_cursor );
 
          if( _previous_play_index < last_index &&
              _previous_play_index > initial_index )
@@ -359,7 +361,7 @@ void TopicPublisherROS::updateState(double current_time)
     if( data_it != _datamap->user_defined.end() )
     {
         const PlotDataAny& continuous_msgs = data_it->second;
-        _previous_play_index = continuous_msgs.getIndexFromX(current_time);
+        _previous_play_index = continuous_msgs.getIndexFromX(current_time, _play_cursor);
         //qDebug() << QString("u: %1").arg( current_index ).arg(current_time, 0, 'f', 4 );
     }
 
@@ -382,7 +384,7 @@ void TopicPublisherROS::updateState(double current_time)
             continue;
         }
 
-        int last_index = plot_any.getIndexFromX( current_time );
+        int last_index = plot_any.getIndexFromX( current_time, _topic_cursors[topic_name] );
         if( last_index < 0)
         {
             continue;
@@ -431,7 +433,7 @@ void TopicPublisherROS::play(double current_time)
         return;
     }
     const PlotDataAny& continuous_msgs = data_it->second;
-    int current_index = continuous_msgs.getIndexFromX(current_time);
+    int current_index = continuous_msgs.getIndexFromX(current_time, _play_cursor);
 
     if( _previous_play_index > current_index)
     {
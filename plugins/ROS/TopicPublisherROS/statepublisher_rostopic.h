@@ -57,6 +57,10 @@ private:
 
     int _previous_play_index;
 
+    // the playback time moves forward by small steps: start the lookups from the last position
+    PlotDataAny::Cursor _play_cursor;
+    std::unordered_map<std::string, PlotDataAny::Cursor> _topic_cursors;
+
     void publishAnyMsg(const rosbag::MessageInstance& msg_instance);
 };
 
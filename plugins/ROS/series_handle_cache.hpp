@@ -0,0 +1,54 @@
+#ifndef SERIES_HANDLE_CACHE_HPP
+#define SERIES_HANDLE_CACHE_HPP
+
+#include <string>
+#include <vector>
+#include "PlotJuggler/plotdata.h"
+
+/**
+ * Remembers the series handle of each field of a message, by position.
+ * Consecutive messages of the same topic usually have the same fields in the same order,
+ * therefore the (prefixed) name is built and hashed only when the layout changes.
+ */
+class SeriesHandleCache{
+
+public:
+  PlotDataMapRef::SeriesHandle get(PlotDataMapRef& plot_map, size_t field_index,
+                                   const std::string& prefix, const std::string& field_name)
+  {
+    if( field_index >= _fields.size() )
+    {
+      _fields.resize( field_index + 1 );
+    }
+    Field& field = _fields[field_index];
+    if( !field.valid || field.name != field_name )
+    {
+      field.name = field_name;
+      field.handle = plot_map.numericHandle( prefix + field_name );
+      field.valid = true;
+    }
+    return field.handle;
+  }
+
+  void clear() { _fields.clear(); }
+
+  template <typename Function>
+  void forEachHandle(Function func) const
+  {
+    for(const Field& field: _fields)
+    {
+      if( field.valid ) func( field.handle );
+    }
+  }
+
+private:
+  struct Field{
+    Field(): handle(0), valid(false) {}
+    std::string name;
+    PlotDataMapRef::SeriesHandle handle;
+    bool valid;
+  };
+  std::vector<Field> _fields;
+};
+
+#endif // SERIES_HANDLE_CACHE_HPP